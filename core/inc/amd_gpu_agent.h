@@ -49,6 +49,7 @@
 #ifndef HSA_RUNTIME_CORE_INC_AMD_GPU_AGENT_H_
 #define HSA_RUNTIME_CORE_INC_AMD_GPU_AGENT_H_
 
+#include <map>
 #include <vector>
 
 #include "core/inc/runtime.h"
@@ -59,6 +60,8 @@
 #include "core/util/locks.h"
 
 namespace amd {
+class HwAqlCommandProcessor;
+
 
 struct ScratchInfo {
   void* queue_base;
@@ -112,6 +115,11 @@ class GpuAgent : public GpuAgentInt {
 
   void ReleaseQueueScratch(void* base);
 
+  /// @brief Takes back a queue released with hsa_queue_destroy. An idle
+  /// queue is reset and kept for reuse by QueueCreate while the pool has
+  /// room, any other queue is deleted.
+  void ReleaseQueue(HwAqlCommandProcessor* queue);
+
   void TranslateTime(core::Signal* signal, hsa_amd_dispatch_time_t& time);
 
   bool memory_type(hsa_amd_memory_type_t type);
@@ -136,6 +144,9 @@ class GpuAgent : public GpuAgentInt {
  private:
   static const uint32_t maxAqlSize_ = 0x20000;  // 8MB max
 
+  // Most idle queues kept for reuse.
+  static const size_t kMaxIdleQueues = 4;
+
   void SyncClocks();
 
   const HSAuint32 node_id_;
@@ -158,6 +169,11 @@ class GpuAgent : public GpuAgentInt {
 
   KernelMutex lock_, sclock_;
 
+  // Idle queues by ring size in packets, protected by idle_queues_lock_.
+  std::multimap<uint32_t, HwAqlCommandProcessor*> idle_queues_;
+
+  KernelMutex idle_queues_lock_;
+
   HsaClockCounters t0_, t1_;
 
   DISALLOW_COPY_AND_ASSIGN(GpuAgent);
@@ -67,6 +67,20 @@ class HwAqlCommandProcessor : public core::Queue, public core::Signal {
   /// @brief Indicates if queue is valid or not
   bool IsValid() const { return valid_ != NULL; }
 
+  // Returns the agent's queue to its pool of idle queues.
+  void Destroy();
+
+  // Ring size in packets of a queue created with req_size_pkts.
+  static uint32_t RingSize(size_t req_size_pkts);
+
+  // Prepares a drained queue for reuse and marks it invalid, so that handles
+  // kept by its previous owner fail validation while it is idle. Returns
+  // false if packets are still pending, the queue must then be deleted.
+  bool Reset();
+
+  // Marks a queue prepared by Reset valid again for a new owner.
+  void Reuse();
+
   /// @brief Queue interfaces
   hsa_status_t Inactivate() { return HSA_STATUS_SUCCESS; }
 
@@ -341,6 +355,10 @@ class HwAqlCommandProcessor : public core::Queue, public core::Signal {
   void AllocRegisteredRingBuffer(uint32_t queue_size_pkts);
   void FreeRegisteredRingBuffer();
 
+  // Maps ring_buf_alloc_bytes_ of VA with both halves backed by the same
+  // memfd of phys_size_bytes, using huge pages if requested.
+  bool MapRingBuffer(uint32_t phys_size_bytes, bool huge_pages);
+
   // Converts aql_queue_t.[read|write]_dispatch_id to/from AQL packet count.
   // Gfx7/Gfx8 CP interprets these fields as DWORD counts.
   uint64_t DispatchIdToNumPackets(uint64_t dispatch_id);
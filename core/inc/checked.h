@@ -69,6 +69,14 @@ class Checked {
     return object_ == (uintptr_t(this) ^ uintptr_t(code));
   }
 
+ protected:
+  /// @brief Makes IsValid fail until Validate is called, for objects kept
+  /// alive for reuse after their handle was released.
+  void Invalidate() { object_ = 0; }
+
+  /// @brief Makes IsValid succeed again.
+  void Validate() { object_ = uintptr_t(this) ^ uintptr_t(code); }
+
  private:
   uintptr_t object_;
 };
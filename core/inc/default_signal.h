@@ -51,6 +51,7 @@
 
 #include "core/inc/runtime.h"
 #include "core/inc/signal.h"
+#include "core/util/os.h"
 #include "core/util/utils.h"
 
 namespace core {
@@ -155,20 +156,32 @@ class DefaultSignal : public Signal {
   /// @brief see the base class Signal
   __forceinline HsaEvent* EopEvent() { return NULL; }
 
-  /// @brief prevent throwing exceptions
-  void* operator new(size_t size) { return malloc(size); }
+  /// @brief Allocates from the runtime's signal pool, prevents throwing
+  /// exceptions.
+  void* operator new(size_t size) {
+    return Runtime::runtime_singleton_->signal_pool().Alloc(size);
+  }
 
-  /// @brief prevent throwing exceptions
-  void operator delete(void* ptr) { free(ptr); }
+  /// @brief Returns the object's block to the runtime's signal pool.
+  void operator delete(void* ptr) {
+    Runtime::runtime_singleton_->signal_pool().Free(ptr);
+  }
 
- private:
-  /// @variable  Indicates if signal is valid or not.
-  volatile bool invalid_;
+  /// @brief Constructs in a block obtained from the signal pool, used for
+  /// batch creation.
+  void* operator new(size_t size, void* block) { return block; }
 
-  /// @variable Indicates number of threads waiting on this signal.
-  /// Value of zero means no waits.
-  volatile uint32_t waiting_;
+  /// @brief Matches placement new, the block is owned by the caller.
+  void operator delete(void* ptr, void* block) {}
 
+ protected:
+  /// @brief Wakes threads parked in WaitRelaxed or in a multi-signal wait.
+  void Notify() {
+    os::WakeByAddress((volatile uint32_t*)&signal_.value, UINT32_MAX);
+    WakeMultiWaiters();
+  }
+
+ private:
   DISALLOW_COPY_AND_ASSIGN(DefaultSignal);
 };
 
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Pool of KFD events for interrupt driven signals.
+
+#ifndef HSA_RUNTME_CORE_INC_EVENT_POOL_H_
+#define HSA_RUNTME_CORE_INC_EVENT_POOL_H_
+
+#include <vector>
+
+#include "core/inc/thunk.h"
+#include "core/util/locks.h"
+#include "core/util/utils.h"
+
+namespace core {
+
+/// @brief Recycles KFD events so that creating and destroying interrupt
+/// signals does not enter the kernel. Events are created in batches and kept
+/// until the pool is cleared, up to a bound on idle events.
+///
+/// Returned events are not reset. An event returned while set wakes its next
+/// owner's first wait spuriously, which all waits tolerate since they
+/// re-check the signal value.
+class EventPool {
+ public:
+  EventPool();
+
+  ~EventPool();
+
+  /// @brief Takes an event from the pool, creating a batch if it is empty.
+  /// @retval The event, NULL if KFD is out of events.
+  HsaEvent* Alloc();
+
+  /// @brief Returns an event obtained from Alloc.
+  void Free(HsaEvent* event);
+
+  /// @brief Destroys all idle events. Must be called before KFD is closed.
+  void Clear();
+
+ private:
+  /// @brief Number of events created at once when the pool is empty.
+  static const uint32_t kGrowCount = 32;
+
+  /// @brief Idle events beyond this count are destroyed when returned, since
+  /// KFD has a limited number of event slots.
+  static const size_t kMaxIdle = 256;
+
+  /// @brief Creates up to kGrowCount events. Called with lock_ held.
+  /// @retval false if not even one event could be created.
+  bool Grow();
+
+  KernelMutex lock_;
+
+  // Idle events.
+  std::vector<HsaEvent*> free_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventPool);
+};
+
+}  // namespace core
+#endif  // header guard
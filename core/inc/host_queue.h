@@ -51,12 +51,25 @@
 #include "core/inc/queue.h"
 
 namespace core {
+/// @brief User mode queue of a CPU agent. An executor thread owned by the
+/// queue waits on the doorbell and executes agent dispatch and barrier
+/// packets one at a time in queue order, so barrier bits are always honored.
 class HostQueue : public Queue {
  public:
-  HostQueue(uint32_t ring_size);
+  /// @param ring_size Number of packets in the ring, a power of two.
+  /// @param agent Agent owning the queue, the only consumer of the doorbell.
+  /// @param callback Invoked from the executor with errors found in packets,
+  /// may be NULL.
+  HostQueue(uint32_t ring_size, hsa_agent_t agent,
+            HsaEventCallback callback);
 
   ~HostQueue();
 
+  /// @brief Deletes the queue. When called from an agent dispatch handler
+  /// running on this queue's executor, the executor deletes the queue once
+  /// the handler returns instead of joining itself.
+  void Destroy();
+
   hsa_status_t Inactivate() { return HSA_STATUS_SUCCESS; }
 
   uint64_t LoadReadIndexAcquire() {
@@ -152,11 +165,34 @@ class HostQueue : public Queue {
   void operator delete(void*, void*) {}
 
  private:
+  /// @brief Entry point of the executor thread.
+  static void ExecutorLoop(void* arg);
+
+  /// @brief Executes packets as they are published until exit_ is set.
+  void Execute();
+
+  /// @brief Executes one packet and signals its completion.
+  void ExecutePacket(AqlPacket* packet, uint16_t header);
+
+  /// @brief Waits for a barrier dependency to reach zero.
+  /// @retval false if the queue is being destroyed.
+  bool WaitDependency(hsa_signal_t signal);
+
+  /// @brief Queue whose executor is the calling thread, NULL on other
+  /// threads.
+  static thread_local HostQueue* executing_queue_;
+
   static const size_t kRingAlignment = 256;
   const uint32_t size_;
   bool active_;
   void* ring_;
   hsa_signal_t signal_;
+  HsaEventCallback callback_;
+  os::Thread executor_;
+  volatile bool exit_;
+
+  // Set when the executor itself must delete the queue on exit.
+  volatile bool self_destroy_;
 
   DISALLOW_COPY_AND_ASSIGN(HostQueue);
 };
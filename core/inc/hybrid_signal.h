@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// HSA runtime C++ interface file.
+
+#ifndef HSA_RUNTME_CORE_INC_HYBRID_SIGNAL_H_
+#define HSA_RUNTME_CORE_INC_HYBRID_SIGNAL_H_
+
+#include "core/inc/default_signal.h"
+#include "core/inc/runtime.h"
+#include "core/inc/thunk.h"
+#include "core/util/locks.h"
+#include "core/util/utils.h"
+
+namespace core {
+
+/// @brief A memory based signal which attaches a KFD event only while some
+/// thread is blocked on it.
+///
+/// Updates cost the same as DefaultSignal's while nobody blocks. A waiter
+/// which runs out of spin and yield budget attaches an event, publishing its
+/// id and mailbox in the signal so that device writes raise an interrupt,
+/// and blocks on it. The event is detached again when the last blocked
+/// waiter leaves. A device write racing with the attach may not see the
+/// mailbox, so the first block after attaching is bounded.
+/// Also see base class Signal.
+class HybridSignal : public DefaultSignal {
+ public:
+  explicit HybridSignal(hsa_signal_value_t initial_value);
+
+  ~HybridSignal();
+
+  hsa_signal_value_t WaitRelaxed(hsa_signal_condition_t condition,
+                                 hsa_signal_value_t compare_value,
+                                 uint64_t timeout,
+                                 hsa_wait_expectancy_t wait_hint);
+
+  hsa_signal_value_t WaitAcquire(hsa_signal_condition_t condition,
+                                 hsa_signal_value_t compare_value,
+                                 uint64_t timeout,
+                                 hsa_wait_expectancy_t wait_hint);
+
+  /// @brief Attaches the event for a thread blocking in WaitMultiple.
+  HsaEvent* AcquireEvent();
+
+  /// @brief Detaches the event taken by AcquireEvent.
+  void ReleaseEvent() { DetachEvent(); }
+
+  /// @brief Allocates from the runtime's signal pool, prevents throwing
+  /// exceptions.
+  void* operator new(size_t size) {
+    return Runtime::runtime_singleton_->signal_pool().Alloc(size);
+  }
+
+  /// @brief Returns the object's block to the runtime's signal pool.
+  void operator delete(void* ptr) {
+    Runtime::runtime_singleton_->signal_pool().Free(ptr);
+  }
+
+  /// @brief Constructs in a block obtained from the signal pool, used for
+  /// batch creation.
+  void* operator new(size_t size, void* block) { return block; }
+
+  /// @brief Matches placement new, the block is owned by the caller.
+  void operator delete(void* ptr, void* block) {}
+
+ protected:
+  /// @brief Wakes parked waiters and sets the event if one is attached.
+  void Notify();
+
+ private:
+  /// @brief Attaches the event if needed and takes a reference on it.
+  /// @retval false if no event could be created.
+  bool AttachEvent();
+
+  /// @brief Drops a reference on the event, detaching it with the last one.
+  void DetachEvent();
+
+  /// @variable Protects event_ and event_users_, never held across a
+  /// syscall.
+  SpinMutex event_lock_;
+
+  /// @variable Number of waiters, and notifiers setting the event, holding
+  /// the event.
+  uint32_t event_users_;
+
+  /// @variable Attached KFD event, NULL while no thread blocks.
+  HsaEvent* event_;
+
+  DISALLOW_COPY_AND_ASSIGN(HybridSignal);
+};
+
+}  // namespace core
+#endif  // header guard
@@ -62,9 +62,9 @@ namespace core {
 ///
 /// Breaks common/vendor separation - signals in general needs to be re-worked
 /// at the foundation level to make sense in a multi-device system.
-/// Supports only one waiter for now.
-/// KFD changes are needed to support multiple waiters and have device
-/// signaling.
+/// Supports multiple waiters. KFD only latches an event set while no thread
+/// is blocked on it, so a waiter which leaves passes the wakeup on to the
+/// remaining waiters and waits are sliced while more than one thread waits.
 class InterruptSignal : public Signal {
  public:
   explicit InterruptSignal(hsa_signal_value_t initial_value);
@@ -76,7 +76,8 @@ class InterruptSignal : public Signal {
   /// @param num_consumers(input), Number of agents that can wait on
   /// this signal.
   /// @param consumers(input), List of agents that might consume (wait on)
-  /// the signal. Must match the num_consumers param.
+  /// the signal. Must match the num_consumers param. The caller picks this
+  /// class only when a host thread may wait, see Signal::HostMayWait.
   static InterruptSignal* Create(hsa_signal_value_t initial_value,
                                  uint32_t num_consumers,
                                  const hsa_agent_t* consumers);
@@ -171,22 +172,36 @@ class InterruptSignal : public Signal {
   /// @brief See base class Signal.
   __forceinline HsaEvent* EopEvent() { return event_; }
 
-  /// @brief prevent throwing exceptions
-  void* operator new(size_t size) { return malloc(size); }
+  /// @brief Allocates from the runtime's signal pool, prevents throwing
+  /// exceptions.
+  void* operator new(size_t size) {
+    return Runtime::runtime_singleton_->signal_pool().Alloc(size);
+  }
+
+  /// @brief Returns the object's block to the runtime's signal pool.
+  void operator delete(void* ptr) {
+    Runtime::runtime_singleton_->signal_pool().Free(ptr);
+  }
+
+  /// @brief Constructs in a block obtained from the signal pool, used for
+  /// batch creation.
+  void* operator new(size_t size, void* block) { return block; }
 
-  /// @brief prevent throwing exceptions
-  void operator delete(void* ptr) { free(ptr); }
+  /// @brief Matches placement new, the block is owned by the caller.
+  void operator delete(void* ptr, void* block) {}
+
+ protected:
+  /// @brief Sets the KFD event. KFD events stay signaled until waited on, so
+  /// a waiter that registered but has not blocked yet does not lose the wakeup.
+  void Notify() {
+    hsaKmtSetEvent(event_);
+    WakeMultiWaiters();
+  }
 
  private:
   /// @variable KFD event on which the interrupt signal is based on.
   HsaEvent* event_;
 
-  /// @variable Indicates that signal is destroyed.
-  volatile bool invalid_;
-
-  /// @variable Number of threads currently waiting on this signal.
-  volatile uint32_t waiting_;
-
   DISALLOW_COPY_AND_ASSIGN(InterruptSignal);
 };
 
@@ -0,0 +1,244 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+// HSA runtime C++ interface file.
+
+#ifndef HSA_RUNTME_CORE_INC_IPC_SIGNAL_H_
+#define HSA_RUNTME_CORE_INC_IPC_SIGNAL_H_
+
+#include "core/inc/runtime.h"
+#include "core/inc/signal.h"
+#include "core/util/os.h"
+#include "core/util/utils.h"
+
+namespace core {
+
+/// @brief Bookkeeping kept in the shared page of an IPC signal, after the
+/// value. Every process mapping the page may write it, so it holds nothing the
+/// runtime dereferences or closes.
+struct IpcSignalHeader {
+  /// @brief Value of magic in a valid page.
+  static const uint64_t kMagic = 0x4853414950435347ULL;
+
+  uint64_t magic;
+  /// @brief Identifies the signal, a reused descriptor number resolves to a
+  /// page with a different id.
+  uint64_t id;
+  /// @brief Offset of the signal value from the start of the page.
+  uint32_t value_offset;
+  /// @brief Set once the creating process destroyed the signal.
+  volatile uint32_t retired;
+  /// @brief Threads of all processes parked on the value.
+  volatile uint32_t waiters;
+};
+
+/// @brief A signal whose value lives in a shared memory page which other
+/// processes can map.
+///
+/// The object itself stays in private memory, only the value and an
+/// IpcSignalHeader are shared. Waiters of every process park on the value
+/// with a process shared futex and count themselves in the header, which
+/// updaters of every process check before waking them. The page outlives the
+/// creating process while any other process keeps it mapped.
+///
+/// The handle cannot be used in AQL packets since the device writes
+/// completion signals through the handle's own AmdHsaSignal, which is not
+/// shared. Also see base class Signal.
+class IpcSignal : public Signal {
+ public:
+  /// @brief Size of the shared page.
+  static const size_t kPageSize = 4096;
+
+  /// @brief Offset of the IpcSignalHeader in the page.
+  static const size_t kHeaderOffset = 64;
+
+  /// @brief Creates a signal in a new shared page.
+  /// @retval NULL if the page could not be created.
+  static IpcSignal* Create(hsa_signal_value_t initial_value);
+
+  /// @brief Maps the page of a signal created by this or another process.
+  /// @retval NULL if the page could not be opened or does not belong to the
+  /// handle's signal.
+  static IpcSignal* Attach(const hsa_amd_ipc_signal_t& handle);
+
+  /// @brief Unmaps the page, other processes' views are left untouched.
+  ~IpcSignal();
+
+  // Below are various methods corresponding to the APIs, which load/store the
+  // signal value or modify the existing signal value automically and with
+  // specified memory ordering semantics.
+
+  hsa_signal_value_t LoadRelaxed();
+
+  hsa_signal_value_t LoadAcquire();
+
+  void StoreRelaxed(hsa_signal_value_t value);
+
+  void StoreRelease(hsa_signal_value_t value);
+
+  hsa_signal_value_t WaitRelaxed(hsa_signal_condition_t condition,
+                                 hsa_signal_value_t compare_value,
+                                 uint64_t timeout,
+                                 hsa_wait_expectancy_t wait_hint);
+
+  hsa_signal_value_t WaitAcquire(hsa_signal_condition_t condition,
+                                 hsa_signal_value_t compare_value,
+                                 uint64_t timeout,
+                                 hsa_wait_expectancy_t wait_hint);
+
+  void AndRelaxed(hsa_signal_value_t value);
+
+  void AndAcquire(hsa_signal_value_t value);
+
+  void AndRelease(hsa_signal_value_t value);
+
+  void AndAcqRel(hsa_signal_value_t value);
+
+  void OrRelaxed(hsa_signal_value_t value);
+
+  void OrAcquire(hsa_signal_value_t value);
+
+  void OrRelease(hsa_signal_value_t value);
+
+  void OrAcqRel(hsa_signal_value_t value);
+
+  void XorRelaxed(hsa_signal_value_t value);
+
+  void XorAcquire(hsa_signal_value_t value);
+
+  void XorRelease(hsa_signal_value_t value);
+
+  void XorAcqRel(hsa_signal_value_t value);
+
+  void AddRelaxed(hsa_signal_value_t value);
+
+  void AddAcquire(hsa_signal_value_t value);
+
+  void AddRelease(hsa_signal_value_t value);
+
+  void AddAcqRel(hsa_signal_value_t value);
+
+  void SubRelaxed(hsa_signal_value_t value);
+
+  void SubAcquire(hsa_signal_value_t value);
+
+  void SubRelease(hsa_signal_value_t value);
+
+  void SubAcqRel(hsa_signal_value_t value);
+
+  hsa_signal_value_t ExchRelaxed(hsa_signal_value_t value);
+
+  hsa_signal_value_t ExchAcquire(hsa_signal_value_t value);
+
+  hsa_signal_value_t ExchRelease(hsa_signal_value_t value);
+
+  hsa_signal_value_t ExchAcqRel(hsa_signal_value_t value);
+
+  hsa_signal_value_t CasRelaxed(hsa_signal_value_t expected,
+                                hsa_signal_value_t value);
+
+  hsa_signal_value_t CasAcquire(hsa_signal_value_t expected,
+                                hsa_signal_value_t value);
+
+  hsa_signal_value_t CasRelease(hsa_signal_value_t expected,
+                                hsa_signal_value_t value);
+
+  hsa_signal_value_t CasAcqRel(hsa_signal_value_t expected,
+                               hsa_signal_value_t value);
+
+  /// @brief see the base class Signal
+  __forceinline hsa_signal_value_t* ValueLocation() const {
+    return (hsa_signal_value_t*)value_;
+  }
+
+  /// @brief see the base class Signal
+  __forceinline HsaEvent* EopEvent() { return NULL; }
+
+  /// @brief Marks the page retired for other processes if this process
+  /// created the signal, then see base class Signal.
+  bool Retire();
+
+  /// @brief Also true once the creating process destroyed the signal.
+  bool IsRetired() const {
+    return invalid_ || atomic::Load(&header_->retired) != 0;
+  }
+
+  bool GetIpcHandle(hsa_amd_ipc_signal_t* handle) const;
+
+ protected:
+  /// @brief Wakes parked waiters of every process if there are any.
+  void Notify();
+
+ private:
+  IpcSignal(int fd, void* page, uint64_t id, bool creator);
+
+  /// @brief Notifies waiters of every process after the value was modified.
+  __forceinline void NotifyShared() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Notify();
+  }
+
+  template <SignalOp op, std::memory_order order>
+  void ModifyShared(hsa_signal_value_t value);
+
+  /// @variable This process's descriptor and mapping of the page.
+  int fd_;
+  void* page_;
+
+  /// @variable Id of the signal, checked against the page when attaching.
+  uint64_t id_;
+
+  /// @variable Header and value in the mapped page.
+  IpcSignalHeader* header_;
+  volatile int64_t* value_;
+
+  /// @variable True in the process which created the signal.
+  bool creator_;
+
+  DISALLOW_COPY_AND_ASSIGN(IpcSignal);
+};
+
+}  // namespace core
+#endif  // header guard
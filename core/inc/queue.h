@@ -70,7 +70,7 @@ struct AqlPacket {
 /// Release and Relaxed semantics.
 class Queue : public Checked<0xFA3906A679F9DB49> {
  public:
-  Queue() {}
+  Queue() : cached_read_index_(0) {}
   virtual ~Queue() {}
 
   /// @brief Returns the handle of Queue's public data type
@@ -83,7 +83,9 @@ class Queue : public Checked<0xFA3906A679F9DB49> {
   }
 
   /// @brief Transform the public data type of a Queue's data type into an
-  //  instance of it Queue class object
+  //  instance of it Queue class object. hsa_queue_t* is part of the public
+  //  ABI and carries no generation, a pointer kept past hsa_queue_destroy
+  //  may alias a queue recycled by the agent's idle queue pool.
   ///
   /// @param queue Handle of public data type of a queue
   ///
@@ -98,6 +100,10 @@ class Queue : public Checked<0xFA3906A679F9DB49> {
                            : NULL;
   }
 
+  /// @brief Releases the queue on behalf of hsa_queue_destroy. Queues which
+  /// are expensive to create may be recycled instead of deleted.
+  virtual void Destroy() { delete this; }
+
   /// @brief Inactivate the queue object. Once inactivate a
   /// queue cannot be used anymore and must be destroyed
   ///
@@ -208,10 +214,24 @@ class Queue : public Checked<0xFA3906A679F9DB49> {
   /// @return uint64_t Value of write index before the update
   virtual uint64_t AddWriteIndexRelease(uint64_t value) = 0;
 
+  /// @brief Writes packets to consecutive slots and rings the doorbell
+  /// once. Slots are reserved with a single write index update, waiting for
+  /// the packet processor to free enough of them. Packet bodies are copied
+  /// before the headers are published in order with release semantics.
+  ///
+  /// @param packets Array of count AQL packets, headers included
+  ///
+  /// @param count Number of packets, at most the queue size
+  void Submit(const AqlPacket* packets, uint32_t count);
+
   // Handle of Amd Queue struct
   amd_queue_t amd_queue_;
 
  private:
+  /// @variable Last read index observed by Submit, a lower bound of the
+  /// current one which saves reading it while the ring has room.
+  volatile uint64_t cached_read_index_;
+
   DISALLOW_COPY_AND_ASSIGN(Queue);
 };
 }
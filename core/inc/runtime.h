@@ -55,16 +55,22 @@
 #define HSA_IMPORT
 
 #include "inc/hsa.h"
+#include "inc/hsa_ext_amd.h"
 #include "core/inc/hsa_ext_interface.h"
 
 #include "core/inc/agent.h"
+#include "core/inc/event_pool.h"
 #include "core/inc/memory_region.h"
 #include "core/inc/memory_database.h"
+#include "core/inc/signal_pool.h"
+#include "core/inc/system_clock.h"
 #include "core/util/utils.h"
 #include "core/util/locks.h"
 
 namespace core {
 extern bool g_use_interrupt_wait;
+extern bool g_use_hybrid_wait;
+extern bool g_signal_stats;
 
 /// @brief  Singleton for helper library attach/cleanup.
 /// Protects global classes from automatic destruction during process exit.
@@ -117,8 +123,45 @@ class Runtime {
   bool RegisterWithDrivers(void* ptr, size_t length);
   void DeregisterWithDrivers(void* ptr);
 
+  /// @brief Registers a handler to be invoked from the runtime's async events
+  /// thread once the signal satisfies the condition. The handler stays
+  /// registered for as long as it returns true. If the handler is dropped
+  /// before returning false, because the signal was destroyed or the runtime
+  /// shut down, cancel is called with arg instead, unless it is NULL.
+  hsa_status_t SetAsyncSignalHandler(hsa_signal_t signal,
+                                     hsa_signal_condition_t cond,
+                                     hsa_signal_value_t value,
+                                     hsa_amd_signal_handler handler, void* arg,
+                                     hsa_amd_signal_cancel_handler cancel =
+                                         NULL);
+
+  /// @brief Sets the host function executing agent dispatch packets of the
+  /// given type, NULL removes it.
+  void SetAgentDispatchHandler(uint16_t type,
+                               hsa_amd_agent_dispatch_handler handler,
+                               void* data);
+
+  /// @brief Looks up the handler of agent dispatch packets of the given type.
+  /// @retval false if no handler is registered.
+  bool GetAgentDispatchHandler(uint16_t type,
+                               hsa_amd_agent_dispatch_handler* handler,
+                               void** data);
+
+  /// @brief Pool from which signal objects are allocated.
+  SignalPool& signal_pool() { return signal_pool_; }
+
+  /// @brief Pool from which interrupt signals borrow KFD events.
+  EventPool& event_pool() { return event_pool_; }
+
+  /// @brief Source of system timestamps.
+  const SystemClock& system_clock() const { return system_clock_; }
+
  private:
-  Runtime() : ref_count_(0), queue_count_(0) {}
+  Runtime() : ref_count_(0), queue_count_(0) {
+    async_events_control_.wake = 0;
+    async_events_control_.async_events_thread_ = NULL;
+    async_events_control_.exit = false;
+  }
 
   Runtime(const Runtime&);
 
@@ -158,6 +201,73 @@ class Runtime {
   // Contains the region, address, and size of previously allocated memory.
   std::map<void*, AllocationRegion> allocation_map_;
 
+  // Cache line padded, pre-registered storage for signals.
+  SignalPool signal_pool_;
+
+  // Recycled KFD events.
+  EventPool event_pool_;
+
+  // User mode system timestamp, calibrated against KFD.
+  SystemClock system_clock_;
+
+  // Host functions executing agent dispatch packets, by packet type.
+  struct AgentDispatchHandler {
+    hsa_amd_agent_dispatch_handler handler;
+    void* data;
+  };
+  std::map<uint16_t, AgentDispatchHandler> agent_dispatch_handlers_;
+  KernelMutex agent_dispatch_lock_;
+
+  // Signal handlers serviced by the async events thread, kept as parallel
+  // arrays so they can be passed to Signal::WaitAny directly. Every signal
+  // but the wake signal at index 0 is retained while its handler is listed.
+  struct AsyncEvents {
+    void PushBack(hsa_signal_t signal, hsa_signal_condition_t cond,
+                  hsa_signal_value_t value, hsa_amd_signal_handler handler,
+                  void* arg, hsa_amd_signal_cancel_handler cancel);
+    void CopyIndex(size_t dst, size_t src);
+    size_t Size() const { return signal_.size(); }
+    void PopBack();
+    void Clear();
+
+    /// @brief Drops the handler at index, moving the last one into its place,
+    /// and releases its signal. Calls the cancel function when cancel is set.
+    void Remove(size_t index, bool cancel);
+
+    /// @brief Cancels every handler from index first on.
+    void RemoveFrom(size_t first);
+
+    KernelMutex lock_;
+    std::vector<hsa_signal_t> signal_;
+    std::vector<hsa_signal_condition_t> cond_;
+    std::vector<hsa_signal_value_t> value_;
+    std::vector<hsa_amd_signal_handler> handler_;
+    std::vector<void*> arg_;
+    std::vector<hsa_amd_signal_cancel_handler> cancel_;
+  };
+
+  struct AsyncEventsControl {
+    // Signal at index 0 of the wait list, raised to interrupt the wait.
+    hsa_signal_t wake;
+    os::Thread async_events_thread_;
+    volatile bool exit;
+    KernelMutex lock;
+  };
+
+  // Handlers owned by the async events thread.
+  AsyncEvents async_events_;
+
+  // Handlers registered since the async events thread last woke.
+  AsyncEvents new_async_events_;
+
+  AsyncEventsControl async_events_control_;
+
+  /// @brief Entry point of the async events thread.
+  static void AsyncEventsLoop(void*);
+
+  /// @brief Stops the async events thread and drops all handlers.
+  void StopAsyncEvents();
+
   // Frees runtime memory when the runtime library is unloaded if safe to do so.
   // Failure to release the runtime indicates an incorrect application but is
   // common (example: calls library routines at process exit).
@@ -51,6 +51,10 @@
 
 #include "core/inc/runtime.h"
 #include "core/inc/checked.h"
+#include "core/inc/wait_policy.h"
+#include "core/util/atomic_helpers.h"
+#include "core/util/os.h"
+#include "core/util/spin_wait.h"
 #include "core/util/utils.h"
 
 #include "core/inc/thunk.h"
@@ -60,6 +64,7 @@ namespace core {
 enum HsaSignalType {
   kHsaSignalInvalid = 0,
   kHsaSignalAmd = 1,
+  kHsaSignalAmdIpc = 2,
   kHsaSignalAmdDoorbell = -1,
   kHsaSignalAmdKvDoorbell = -2
 };
@@ -78,6 +83,29 @@ struct AmdHsaSignal {
   uint64_t end_ts;    // End timestamp for associated AQL packet, when profiled
 };
 
+/// @brief Read-modify-write operations of signals whose value is a plain memory
+/// location.
+enum SignalOp {
+  kSignalOpAnd,
+  kSignalOpOr,
+  kSignalOpXor,
+  kSignalOpAdd,
+  kSignalOpSub
+};
+
+/// @brief Wait statistics accumulated by one signal. See
+/// hsa_amd_signal_stats_t.
+struct SignalStats {
+  volatile uint64_t wait_count;
+  volatile uint64_t timeout_count;
+  volatile uint64_t wait_time_ns;
+  volatile uint64_t blocked_time_ns;
+  volatile uint64_t spin_count;
+  volatile uint64_t block_count;
+  volatile uint64_t notified_wake_count;
+  volatile uint64_t timed_wake_count;
+};
+
 /// @brief An abstract base class which helps implement the public hsa_signal_t
 /// type (an opaque handle) and its associated APIs. At its core, signal uses
 /// a 32 or 64 bit value. This value can be waitied open or signaled atomically
@@ -85,12 +113,16 @@ struct AmdHsaSignal {
 class Signal : public Checked<0x71FCCA6A3D5D5276> {
  public:
   /// @brief Constructor initializes the signal with initial value.
-  explicit Signal(hsa_signal_value_t initial_value) {
+  explicit Signal(hsa_signal_value_t initial_value)
+      : invalid_(false), waiting_(0), wait_history_(0), stats_(NULL) {
     signal_.type = kHsaSignalInvalid;
     signal_.value = initial_value;
   }
 
-  virtual ~Signal() { signal_.type = kHsaSignalInvalid; }
+  virtual ~Signal() {
+    signal_.type = kHsaSignalInvalid;
+    delete stats_;
+  }
 
   /// @brief Converts from this implementation class to the public
   /// hsa_signal_t type - an opaque handle.
@@ -107,7 +139,10 @@ class Signal : public Checked<0x71FCCA6A3D5D5276> {
   }
 
   /// @brief Converts from public hsa_signal_t type (an opaque handle) to
-  /// this implementation class object.
+  /// this implementation class object. The handle is the address of the
+  /// amd_signal_t read by the packet processor, so it carries no generation:
+  /// a handle kept past hsa_signal_destroy may alias a signal later allocated
+  /// from the same signal pool block.
   static __forceinline Signal* Convert(hsa_signal_t signal) {
     return (signal == NULL)
                ? NULL
@@ -179,6 +214,67 @@ class Signal : public Checked<0x71FCCA6A3D5D5276> {
   // implementation specific
   //-------------------------
 
+  /// @brief True for signals whose operations are plain atomics on
+  /// signal_.value followed by a notification when there are waiters. The
+  /// API uses the inline operations below for these instead of the virtual
+  /// methods.
+  __forceinline bool IsMemorySignal() const {
+    return signal_.type == kHsaSignalAmd;
+  }
+
+  // Inline operations of memory signals, one template per operation covering
+  // all memory orders.
+
+  template <std::memory_order order>
+  __forceinline hsa_signal_value_t Load() const {
+    return hsa_signal_value_t(atomic::Load(&signal_.value, order));
+  }
+
+  template <std::memory_order order>
+  __forceinline void Store(hsa_signal_value_t value) {
+    atomic::Store(&signal_.value, int64_t(value), order);
+    NotifyIfWaiting();
+  }
+
+  template <SignalOp op, std::memory_order order>
+  __forceinline void Modify(hsa_signal_value_t value) {
+    switch (op) {
+      case kSignalOpAnd:
+        atomic::And(&signal_.value, int64_t(value), order);
+        break;
+      case kSignalOpOr:
+        atomic::Or(&signal_.value, int64_t(value), order);
+        break;
+      case kSignalOpXor:
+        atomic::Xor(&signal_.value, int64_t(value), order);
+        break;
+      case kSignalOpAdd:
+        atomic::Add(&signal_.value, int64_t(value), order);
+        break;
+      case kSignalOpSub:
+        atomic::Sub(&signal_.value, int64_t(value), order);
+        break;
+    }
+    NotifyIfWaiting();
+  }
+
+  template <std::memory_order order>
+  __forceinline hsa_signal_value_t Exchange(hsa_signal_value_t value) {
+    hsa_signal_value_t ret = hsa_signal_value_t(
+        atomic::Exchange(&signal_.value, int64_t(value), order));
+    NotifyIfWaiting();
+    return ret;
+  }
+
+  template <std::memory_order order>
+  __forceinline hsa_signal_value_t CompareExchange(hsa_signal_value_t expected,
+                                                   hsa_signal_value_t value) {
+    hsa_signal_value_t ret = hsa_signal_value_t(atomic::Cas(
+        &signal_.value, int64_t(value), int64_t(expected), order));
+    if (ret == expected) NotifyIfWaiting();
+    return ret;
+  }
+
   /// @brief Returns the address of the value.
   virtual hsa_signal_value_t* ValueLocation() const = 0;
 
@@ -186,12 +282,294 @@ class Signal : public Checked<0x71FCCA6A3D5D5276> {
   /// Returns NULL for DefaultEvent Type.
   virtual HsaEvent* EopEvent() = 0;
 
+  /// @brief Returns a KFD event which is set by every write to the signal,
+  /// attaching one if the signal only does so on demand. Used by WaitMultiple
+  /// to block on several signals in the kernel.
+  /// @retval NULL if the signal has no event, writes are then only seen by
+  /// polling.
+  virtual HsaEvent* AcquireEvent() { return EopEvent(); }
+
+  /// @brief Drops the event returned by a successful AcquireEvent.
+  virtual void ReleaseEvent() {}
+
+  /// @brief Evaluates a wait condition against a signal value.
+  /// @param condition Condition to evaluate.
+  /// @param value Observed signal value.
+  /// @param compare_value Value the condition compares against.
+  /// @retval true if the condition is satisfied.
+  static __forceinline bool CheckCondition(hsa_signal_condition_t condition,
+                                           hsa_signal_value_t value,
+                                           hsa_signal_value_t compare_value) {
+    switch (uint32_t(condition)) {
+      case HSA_EQ:
+        return value == compare_value;
+      case HSA_NE:
+        return value != compare_value;
+      case HSA_GTE:
+        return value >= compare_value;
+      case HSA_LT:
+        return value < compare_value;
+      case HSA_AMD_ALL_BITS_SET:
+        return (value & compare_value) == compare_value;
+      case HSA_AMD_ANY_BIT_SET:
+        return (value & compare_value) != 0;
+      default:
+        return false;
+    }
+  }
+
+  /// @brief True if condition is one of the conditions CheckCondition
+  /// evaluates.
+  static __forceinline bool IsValidCondition(hsa_signal_condition_t condition) {
+    switch (uint32_t(condition)) {
+      case HSA_EQ:
+      case HSA_NE:
+      case HSA_GTE:
+      case HSA_LT:
+      case HSA_AMD_ALL_BITS_SET:
+      case HSA_AMD_ANY_BIT_SET:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  /// @brief Waits until any of the signals satisfies its condition.
+  /// @param signal_count Number of signals in the arrays.
+  /// @param hsa_signals Signals to wait on.
+  /// @param conds Condition for each signal.
+  /// @param values Compare value for each signal.
+  /// @param timeout Maximum wait duration in system timestamp units.
+  /// @param wait_hint Expected wait duration.
+  /// @param satisfying_value If not NULL, receives the value observed on the
+  /// satisfying signal.
+  /// @retval Index of the satisfying signal, or UINT32_MAX if the wait timed
+  /// out or one of the signals was destroyed.
+  static uint32_t WaitAny(uint32_t signal_count,
+                          const hsa_signal_t* hsa_signals,
+                          const hsa_signal_condition_t* conds,
+                          const hsa_signal_value_t* values, uint64_t timeout,
+                          hsa_wait_expectancy_t wait_hint,
+                          hsa_signal_value_t* satisfying_value);
+
+  /// @brief Waits until every signal has been observed satisfying its
+  /// condition. A signal which satisfied its condition is not checked again.
+  /// @param satisfying_values If not NULL, receives the value observed on each
+  /// signal when its condition was satisfied.
+  /// @retval Number of signals which satisfied their condition, equal to
+  /// signal_count unless the wait timed out or a signal was destroyed.
+  /// @brief See WaitAny for the remaining parameters.
+  static uint32_t WaitAll(uint32_t signal_count,
+                          const hsa_signal_t* hsa_signals,
+                          const hsa_signal_condition_t* conds,
+                          const hsa_signal_value_t* values, uint64_t timeout,
+                          hsa_wait_expectancy_t wait_hint,
+                          hsa_signal_value_t* satisfying_values);
+
+  /// @brief Checks whether a host thread may wait on a signal. Only such
+  /// signals need a KFD event to sleep on, device waiters poll the value.
+  /// @param num_consumers Number of agents in consumers.
+  /// @param consumers Agents which may wait on the signal.
+  /// @retval true if consumers is empty, meaning any agent, or lists a CPU
+  /// agent.
+  static bool HostMayWait(uint32_t num_consumers,
+                          const hsa_agent_t* consumers);
+
+  /// @brief Copies this signal's wait statistics, all zero if none were
+  /// recorded.
+  void GetStats(hsa_amd_signal_stats_t* stats) const;
+
+  /// @brief Number of buckets in the process wide wait duration histogram.
+  static const uint32_t kWaitHistogramBuckets =
+      HSA_AMD_SIGNAL_WAIT_HISTOGRAM_BUCKETS;
+
+  /// @brief Copies the process wide wait duration histogram. Bucket i counts
+  /// waits which took [2^i, 2^(i+1)) nanoseconds, the last bucket also counts
+  /// all longer waits.
+  static void GetWaitHistogram(uint64_t* buckets, uint32_t bucket_count);
+
+  /// @brief Marks the signal invalid and wakes its waiters without waiting
+  /// for them to leave. If a waiter remains, the last one to leave deletes
+  /// the signal.
+  /// @retval true if no thread waits, the caller must then delete the signal.
+  virtual bool Retire();
+
+  /// @brief Gets the handle other processes use to attach to this signal.
+  /// @retval false if the signal is not shared between processes.
+  virtual bool GetIpcHandle(hsa_amd_ipc_signal_t* handle) const {
+    return false;
+  }
+
+  /// @brief Retires the signal and deletes it unless a waiter remains.
+  void Destroy() {
+    if (Retire()) delete this;
+  }
+
+  /// @brief Holds a waiter reference for a thread which watches the signal
+  /// across waits, keeping it from being deleted once retired.
+  void Retain() { AddWaiter(); }
+
+  /// @brief Drops a reference taken by Retain. The signal must not be touched
+  /// afterwards.
+  void Release() { RemoveWaiter(); }
+
+  /// @brief True once the signal has been retired, or for a shared signal
+  /// once its owner destroyed it. Only meaningful while the caller holds a
+  /// reference.
+  virtual bool IsRetired() const { return invalid_; }
+
   /// @brief Structure which defines key signal elements like type and value.
   /// Address of this struct is used as a value for the opaque handle of type
   /// hsa_signal_t provided to the public API.
   AmdHsaSignal signal_;
 
+ protected:
+  /// @brief Flag in waiting_ set once the signal has been retired.
+  static const uint32_t kRetired = 0x80000000;
+
+  /// @brief Registers a waiter. Must precede the waiter's first sample of
+  /// the value.
+  __forceinline void AddWaiter() {
+    atomic::Increment(&waiting_, std::memory_order_seq_cst);
+  }
+
+  /// @brief Unregisters a waiter. The signal must not be touched afterwards
+  /// since the last waiter of a retired signal deletes it.
+  __forceinline void RemoveWaiter() {
+    if (atomic::Decrement(&waiting_, std::memory_order_acq_rel) ==
+        (kRetired | 1))
+      delete this;
+  }
+
+  /// @brief Number of threads waiting on this signal.
+  __forceinline uint32_t Waiters() const { return waiting_ & ~kRetired; }
+
+  /// @brief Wakes the threads waiting on this signal after its value changed.
+  /// Only called while waiting_ is non-zero.
+  virtual void Notify() {}
+
+  /// @brief Notifies waiters, if any, after the value has been modified. A
+  /// waiter registers in waiting_ before sampling the value, so either the
+  /// waiter sees the new value or this sees the waiter.
+  __forceinline void NotifyIfWaiting() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_ != 0) Notify();
+  }
+
+  /// @brief Wakes threads blocked in WaitAny or WaitAll. Must be called after
+  /// the value of a signal with a non-zero waiting_ count is modified.
+  static __forceinline void WakeMultiWaiters() {
+    if (multi_waiters_ != 0) {
+      atomic::Increment(&multi_wait_word_);
+      os::WakeByAddress(&multi_wait_word_, UINT32_MAX);
+    }
+  }
+
+  /// @variable  Indicates if signal is valid or not.
+  volatile bool invalid_;
+
+  /// @variable Indicates number of threads waiting on this signal, plus
+  /// kRetired once retired. Value of zero means no waits.
+  volatile uint32_t waiting_;
+
+  /// @variable Typical wait duration in microseconds, learned by WaitPolicy.
+  /// Zero until the first wait is satisfied.
+  volatile uint32_t wait_history_;
+
+  /// @brief Collects the statistics of one wait and adds them to the signal
+  /// and the process histogram when destroyed. Does nothing unless statistics
+  /// are enabled, and compiles away when HSA_NO_SIGNAL_STATS is defined.
+  class WaitRecord {
+   public:
+    explicit WaitRecord(Signal* signal)
+        : signal_(signal),
+          enabled_(false),
+          timed_out_(false),
+          spins_(0),
+          start_(0),
+          block_start_(0),
+          blocked_ticks_(0),
+          blocks_(0),
+          notified_wakes_(0) {
+#ifndef HSA_NO_SIGNAL_STATS
+      enabled_ = g_signal_stats;
+      if (enabled_) start_ = Now();
+#endif
+    }
+
+    ~WaitRecord() {
+#ifndef HSA_NO_SIGNAL_STATS
+      if (enabled_) Publish();
+#endif
+    }
+
+    /// @brief Counts a failed condition check made while spinning.
+    __forceinline void Spin() { spins_++; }
+
+    /// @brief Marks the wait as timed out.
+    __forceinline void Timeout() { timed_out_ = true; }
+
+    /// @brief Brackets a blocking call.
+    __forceinline void BlockBegin() {
+#ifndef HSA_NO_SIGNAL_STATS
+      if (enabled_) block_start_ = Now();
+#endif
+    }
+    /// @param notified false if the blocking call returned because its time
+    /// slice expired.
+    __forceinline void BlockEnd(bool notified) {
+#ifndef HSA_NO_SIGNAL_STATS
+      if (!enabled_) return;
+      blocked_ticks_ += Now() - block_start_;
+      blocks_++;
+      if (notified) notified_wakes_++;
+#endif
+    }
+
+   private:
+    /// @brief Adds the collected statistics to the signal and the histogram.
+    void Publish();
+
+    static __forceinline uint64_t Now() {
+      return Runtime::runtime_singleton_->system_clock().Timestamp();
+    }
+
+    Signal* signal_;
+    bool enabled_;
+    bool timed_out_;
+    uint64_t spins_;
+    uint64_t start_;
+    uint64_t block_start_;
+    uint64_t blocked_ticks_;
+    uint64_t blocks_;
+    uint64_t notified_wakes_;
+
+    DISALLOW_COPY_AND_ASSIGN(WaitRecord);
+  };
+
  private:
+  /// @brief Common implementation of WaitAny and WaitAll.
+  static uint32_t WaitMultiple(bool wait_all, uint32_t signal_count,
+                               const hsa_signal_t* hsa_signals,
+                               const hsa_signal_condition_t* conds,
+                               const hsa_signal_value_t* values,
+                               uint64_t timeout,
+                               hsa_wait_expectancy_t wait_hint,
+                               hsa_signal_value_t* satisfying_values);
+
+  /// @variable Number of threads blocked in WaitAny or WaitAll.
+  static volatile uint32_t multi_waiters_;
+
+  /// @variable Futex word shared by all multi-signal waiters, bumped whenever
+  /// a signal they may be waiting on changes.
+  static volatile uint32_t multi_wait_word_;
+
+  /// @variable Wait statistics, allocated by the first recorded wait.
+  SignalStats* volatile stats_;
+
+  /// @variable Process wide histogram of wait durations.
+  static volatile uint64_t wait_histogram_[kWaitHistogramBuckets];
+
   DISALLOW_COPY_AND_ASSIGN(Signal);
 };
 
@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Slab allocator for signal objects.
+
+#ifndef HSA_RUNTME_CORE_INC_SIGNAL_POOL_H_
+#define HSA_RUNTME_CORE_INC_SIGNAL_POOL_H_
+
+#include <vector>
+
+#include "core/util/locks.h"
+#include "core/util/utils.h"
+
+namespace core {
+
+/// @brief Pool of fixed size, cache line aligned blocks for signal objects.
+/// Blocks are carved from slabs which are registered once and never returned
+/// to the system while the pool lives, freed blocks are recycled. Each thread
+/// keeps a small cache of free blocks to avoid taking the pool lock.
+class SignalPool {
+ public:
+  /// @brief Size of each block, a whole number of cache lines so that no two
+  /// signals share a line.
+  static const size_t kBlockSize = 128;
+
+  SignalPool();
+
+  ~SignalPool();
+
+  /// @brief Allocates a block.
+  /// @param size Size of the object to place in the block, must not exceed
+  /// kBlockSize.
+  /// @retval Pointer to the block, NULL if out of memory.
+  void* Alloc(size_t size);
+
+  /// @brief Returns a block obtained from Alloc to the pool.
+  void Free(void* ptr);
+
+  /// @brief Allocates count blocks under a single acquisition of the pool
+  /// lock. When the pool runs dry one slab large enough for the rest of the
+  /// batch is added, so large batches occupy a contiguous registered range.
+  /// @param size Size of the objects, must not exceed kBlockSize.
+  /// @param count Number of blocks to allocate.
+  /// @param blocks Receives the blocks, in address order for fresh memory.
+  /// @retval false if out of memory, no blocks are allocated then.
+  bool AllocBatch(size_t size, uint32_t count, void** blocks);
+
+  /// @brief Returns count blocks to the pool under a single acquisition of
+  /// the pool lock.
+  void FreeBatch(void* const* blocks, uint32_t count);
+
+  /// @brief Enables or disables the per thread block caches.
+  void EnableThreadCache(bool enable) { thread_cache_enabled_ = enable; }
+
+ private:
+  /// @brief Link overlaid on free blocks.
+  struct Block {
+    Block* next;
+  };
+
+  /// @brief A registered range carved into blocks.
+  struct Slab {
+    void* base;
+    size_t size;
+  };
+
+  class ThreadCache;
+
+  /// @brief Size and alignment of slabs.
+  static const size_t kSlabSize = 64 * 1024;
+  static const size_t kSlabAlignment = 4096;
+
+  /// @brief Number of free blocks a thread may cache before returning half of
+  /// them to the pool.
+  static const uint32_t kThreadCacheBlocks = 64;
+
+  /// @brief Carves a new slab of size bytes, a multiple of kSlabSize, into
+  /// the free list. Called with lock_ held.
+  bool Grow(size_t size = kSlabSize);
+
+  /// @brief Links a thread's cache to this pool.
+  void AttachCache(ThreadCache* cache);
+
+  /// @brief Returns a thread's cached blocks to the pool and unlinks it.
+  /// Called with cache_lock_ held.
+  void DetachCache(ThreadCache* cache);
+
+  /// @brief Moves count blocks from the head of a thread's cache to the free
+  /// list. Called with lock_ held.
+  void Reclaim(ThreadCache* cache, uint32_t count);
+
+  KernelMutex lock_;
+
+  // Pool wide list of free blocks.
+  Block* free_list_;
+
+  // Slabs owned by the pool.
+  std::vector<Slab> slabs_;
+
+  // Thread caches holding blocks from this pool.
+  std::vector<ThreadCache*> caches_;
+
+  bool thread_cache_enabled_;
+
+  static thread_local ThreadCache thread_cache_;
+
+  // Guards the link between thread caches and pools, so that a thread exiting
+  // while a pool is destroyed either detaches first or finds itself unlinked.
+  // Taken before lock_.
+  static KernelMutex cache_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(SignalPool);
+};
+
+}  // namespace core
+#endif  // header guard
@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// User mode system timestamp service.
+
+#ifndef HSA_RUNTME_CORE_INC_SYSTEM_CLOCK_H_
+#define HSA_RUNTME_CORE_INC_SYSTEM_CLOCK_H_
+
+#include "core/util/atomic_helpers.h"
+#include "core/util/os.h"
+#include "core/util/utils.h"
+
+namespace core {
+
+/// @brief Answers system timestamp queries from the CPU time stamp counter.
+/// The TSC is calibrated against the KFD system clock counter when started
+/// and re-calibrated by a background thread. Re-calibration slews the
+/// conversion so the timestamp stays continuous and monotonic. Falls back to
+/// querying KFD when the TSC is not invariant.
+class SystemClock {
+ public:
+  SystemClock();
+
+  ~SystemClock();
+
+  /// @brief Calibrates the clock and starts re-calibration. Requires KFD to be
+  /// open.
+  void Start();
+
+  /// @brief Stops re-calibration.
+  void Stop();
+
+  /// @brief Returns the current system timestamp, in units of Frequency().
+  __forceinline uint64_t Timestamp() const {
+    if (!use_tsc_) return QueryCounter();
+
+    // The TSC is read inside the sequence lock, so a timestamp computed with
+    // replaced parameters predates their replacement, see Calibrate.
+    uint64_t tsc_base, counter_base, scale, tsc;
+    uint32_t seq;
+    do {
+      seq = atomic::Load(&seq_, std::memory_order_acquire);
+      tsc_base = atomic::Load(&tsc_base_, std::memory_order_relaxed);
+      counter_base = atomic::Load(&counter_base_, std::memory_order_relaxed);
+      scale = atomic::Load(&scale_, std::memory_order_relaxed);
+      tsc = __rdtsc();
+      _mm_lfence();
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 ||
+             seq != atomic::Load(&seq_, std::memory_order_relaxed));
+
+    return counter_base + ScaleTicks(tsc - tsc_base, scale);
+  }
+
+  /// @brief Returns the frequency of the system timestamp in Hz.
+  __forceinline uint64_t Frequency() const { return frequency_; }
+
+  /// @brief Returns the measured rate of the CPU time stamp counter in Hz, or
+  /// 0 if it could not be measured. Only approximate when the TSC is not
+  /// invariant.
+  __forceinline uint64_t TscFrequency() const { return tsc_frequency_; }
+
+  /// @brief Converts a system timestamp interval to nanoseconds.
+  __forceinline uint64_t TicksToNs(uint64_t ticks) const {
+    return uint64_t(double(ticks) * ns_per_tick_);
+  }
+
+ private:
+  /// @brief Fixed point precision of scale_.
+  static const uint32_t kScaleShift = 32;
+
+  /// @brief Returns (ticks * scale) >> kScaleShift without overflowing the
+  /// intermediate product.
+  static __forceinline uint64_t ScaleTicks(uint64_t ticks, uint64_t scale) {
+#ifdef __SIZEOF_INT128__
+    return uint64_t((unsigned __int128)ticks * scale >> kScaleShift);
+#else
+    // Sum of 32x32 bit partial products, the dropped low bits only reach the
+    // result through the lowest product.
+    static_assert(kScaleShift == 32, "Partial products assume a 32 bit shift");
+    uint64_t ticks_lo = uint32_t(ticks), ticks_hi = ticks >> 32;
+    uint64_t scale_lo = uint32_t(scale), scale_hi = scale >> 32;
+    return ((ticks_hi * scale_hi) << 32) + ticks_hi * scale_lo +
+           ticks_lo * scale_hi + ((ticks_lo * scale_lo) >> 32);
+#endif
+  }
+
+  /// @brief Reads the KFD system clock counter.
+  static uint64_t QueryCounter();
+
+  /// @brief Samples the TSC and KFD counter together, bracketing the query
+  /// with TSC reads and using the midpoint.
+  static void Sample(uint64_t& tsc, uint64_t& counter);
+
+  /// @brief Measures the rate against the first sample and installs new
+  /// conversion parameters which converge on the measured clock over
+  /// horizon_ns.
+  void Calibrate(uint64_t horizon_ns);
+
+  /// @brief Opens the sequence lock for an update of the conversion
+  /// parameters. TSC reads which follow are ordered after it.
+  void BeginPublish();
+
+  /// @brief Stores new conversion parameters and closes the sequence lock.
+  void EndPublish(uint64_t tsc_base, uint64_t counter_base, uint64_t scale);
+
+  /// @brief Entry point of the re-calibration thread.
+  static void CalibrationLoop(void* clock);
+
+  /// @variable Sequence lock protecting the conversion parameters, odd while
+  /// they are being updated.
+  volatile uint32_t seq_;
+
+  /// @variable Conversion parameters: timestamp = counter_base_ +
+  /// ((tsc - tsc_base_) * scale_ >> kScaleShift).
+  volatile uint64_t tsc_base_;
+  volatile uint64_t counter_base_;
+  volatile uint64_t scale_;
+
+  /// @variable First calibration sample, the baseline for rate measurement.
+  uint64_t tsc_origin_;
+  uint64_t counter_origin_;
+
+  uint64_t frequency_;
+  uint64_t tsc_frequency_;
+  double ns_per_tick_;
+  bool use_tsc_;
+
+  os::Thread thread_;
+
+  /// @variable Non-zero when the re-calibration thread must exit.
+  volatile uint32_t stop_;
+
+  DISALLOW_COPY_AND_ASSIGN(SystemClock);
+};
+
+}  // namespace core
+#endif  // header guard
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Spin, yield and block phases of signal waits.
+
+#ifndef HSA_RUNTME_CORE_INC_WAIT_POLICY_H_
+#define HSA_RUNTME_CORE_INC_WAIT_POLICY_H_
+
+#include "inc/hsa.h"
+#include "core/util/utils.h"
+
+namespace core {
+
+/// @brief Decides how a thread waiting on signals spends its time as the wait
+/// ages: spinning on the value, yielding the CPU, or blocking in the kernel.
+///
+/// HSA_WAIT_EXPECTANCY_SHORT waits spin for the maximum spin budget, then
+/// yield, and never block. HSA_WAIT_EXPECTANCY_LONG waits spin for the minimum
+/// budget and then block. HSA_WAIT_EXPECTANCY_UNKNOWN waits spin for a budget
+/// learned from the recent wait durations of the signal, then yield for a
+/// while before blocking. Signals which are usually satisfied within the
+/// spin budget spin a little longer than their typical wait, signals which are
+/// not spin only briefly.
+///
+/// Budgets are tunable through HSA_WAIT_SPIN_US, HSA_WAIT_MIN_SPIN_US and
+/// HSA_WAIT_YIELD_US.
+class WaitPolicy {
+ public:
+  enum Phase { kSpin, kYield, kBlock };
+
+  /// @brief Reads the tunable budgets. Must be called once the system clock
+  /// has been started.
+  static void LoadSettings();
+
+  /// @param hint wait expectancy given by the caller.
+  /// @param history per signal wait history, NULL when the wait is not on a
+  /// single signal.
+  WaitPolicy(hsa_wait_expectancy_t hint, volatile uint32_t* history);
+
+  /// @brief Returns the phase the wait is in.
+  __forceinline Phase Next() const {
+    uint64_t elapsed = __rdtsc() - start_;
+    if (elapsed < spin_ticks_) return kSpin;
+    if (elapsed < yield_ticks_) return kYield;
+    return kBlock;
+  }
+
+  /// @brief Records the duration of a satisfied wait in the signal history.
+  void Satisfied();
+
+ private:
+  /// @variable Budgets in TSC ticks.
+  static uint64_t max_spin_ticks_;
+  static uint64_t min_spin_ticks_;
+  static uint64_t yield_ticks_per_wait_;
+
+  /// @variable TSC ticks per microsecond.
+  static uint64_t ticks_per_us_;
+
+  volatile uint32_t* history_;
+  uint64_t start_;
+
+  /// @variable End of the spin and yield phases, relative to start_.
+  uint64_t spin_ticks_;
+  uint64_t yield_ticks_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaitPolicy);
+};
+
+}  // namespace core
+#endif  // header guard
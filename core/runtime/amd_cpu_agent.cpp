@@ -201,9 +201,10 @@ hsa_status_t CpuAgent::QueueCreate(size_t size, hsa_queue_type_t type,
   if (!IsPowerOfTwo(size))
     return HSA_STATUS_ERROR;  // AQL queues must be a power of two in length.
 
-  core::HostQueue* host_queue = new core::HostQueue(uint32_t(size));
+  core::HostQueue* host_queue =
+      new core::HostQueue(uint32_t(size), Convert(this), callback);
   if (!host_queue->active()) {
-    delete queue;
+    delete host_queue;
     return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
   }
   *queue = host_queue;
@@ -151,6 +151,13 @@ GpuAgent::GpuAgent(HSAuint32 node, const HsaNodeProperties& node_props,
 }
 
 GpuAgent::~GpuAgent() {
+  // Idle queues release their scratch into scratch_pool_.
+  for (std::multimap<uint32_t, HwAqlCommandProcessor*>::iterator it =
+           idle_queues_.begin();
+       it != idle_queues_.end(); ++it)
+    delete it->second;
+  idle_queues_.clear();
+
   if (ape1_base_ != 0)
     ReleaseApe1(reinterpret_cast<void*>(ape1_base_), ape1_size_);
 
@@ -309,6 +316,20 @@ hsa_status_t GpuAgent::QueueCreate(size_t size, hsa_queue_type_t type,
   // Enforce max size
   if (size > maxAqlSize_) return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
 
+  // Reuse an idle queue with the same ring size, skipping queue and scratch
+  // setup.
+  {
+    ScopedAcquire<KernelMutex> lock(&idle_queues_lock_);
+    std::multimap<uint32_t, HwAqlCommandProcessor*>::iterator it =
+        idle_queues_.find(HwAqlCommandProcessor::RingSize(size));
+    if (it != idle_queues_.end()) {
+      it->second->Reuse();
+      *queue = it->second;
+      idle_queues_.erase(it);
+      return HSA_STATUS_SUCCESS;
+    }
+  }
+
   // Allocate scratch memory
   ScratchInfo scratch;
   {
@@ -339,6 +360,25 @@ void GpuAgent::ReleaseQueueScratch(void* base) {
   scratch_pool_.free(base);
 }
 
+void GpuAgent::ReleaseQueue(HwAqlCommandProcessor* queue) {
+  {
+    ScopedAcquire<KernelMutex> lock(&idle_queues_lock_);
+    // Idle queues fail validation, this only catches destroys racing with
+    // each other.
+    for (std::multimap<uint32_t, HwAqlCommandProcessor*>::iterator it =
+             idle_queues_.begin();
+         it != idle_queues_.end(); ++it)
+      if (it->second == queue) return;
+
+    if (idle_queues_.size() < kMaxIdleQueues && queue->Reset()) {
+      idle_queues_.insert(std::make_pair(
+          uint32_t(core::Queue::Convert(queue)->size), queue));
+      return;
+    }
+  }
+  delete queue;
+}
+
 void GpuAgent::TranslateTime(core::Signal* signal,
                              hsa_amd_dispatch_time_t& time) {
   // Ensure interpolation
@@ -47,11 +47,7 @@
 #include "core/inc/amd_hw_aql_command_processor.h"
 
 #ifdef __linux__
-#include <fcntl.h>
 #include <sys/mman.h>
-#include <sys/stat.h>
-#include <sys/syscall.h>
-#include <unistd.h>
 #endif
 
 #ifdef _WIN32
@@ -65,6 +61,7 @@
 #include "core/inc/amd_memory_region.h"
 #include "core/inc/signal.h"
 #include "core/inc/queue.h"
+#include "core/util/os.h"
 #include "core/util/utils.h"
 
 // When set to 1, the ring buffer is internally doubled in size.
@@ -111,6 +108,13 @@ const uint32_t kRingBufferMinPkts = ComputeRingBufferMinPkts();
 // Queue::amd_queue_ is cache-aligned for performance.
 const uint32_t kAmdQueueAlignBytes = 0x40;
 
+uint32_t HwAqlCommandProcessor::RingSize(size_t req_size_pkts) {
+  // Apply sizing constraints to the ring buffer.
+  uint32_t queue_size_pkts =
+      uint32_t(Min(req_size_pkts, size_t(kRingBufferMaxPkts)));
+  return Max(queue_size_pkts, kRingBufferMinPkts);
+}
+
 void* HwAqlCommandProcessor::operator new(size_t size) {
   // Align base to 64B to enforce amd_queue_ member alignment.
   return _aligned_malloc(size, kAmdQueueAlignBytes);
@@ -135,10 +139,7 @@ HwAqlCommandProcessor::HwAqlCommandProcessor(GpuAgent* agent,
     hsa_status = hsa_memory_register(&amd_queue_, sizeof(amd_queue_));
     if (hsa_status != HSA_STATUS_SUCCESS) break;
 
-    // Apply sizing constraints to the ring buffer.
-    uint32_t queue_size_pkts = uint32_t(req_size_pkts);
-    queue_size_pkts = Min(queue_size_pkts, kRingBufferMaxPkts);
-    queue_size_pkts = Max(queue_size_pkts, kRingBufferMinPkts);
+    uint32_t queue_size_pkts = RingSize(req_size_pkts);
 
     uint32_t queue_size_bytes = queue_size_pkts * sizeof(core::AqlPacket);
     if ((queue_size_bytes & (queue_size_bytes - 1)) != 0) break;
@@ -305,6 +306,29 @@ HwAqlCommandProcessor::~HwAqlCommandProcessor() {
   agent_->ReleaseQueueScratch(queue_scratch_.queue_base);
 }
 
+void HwAqlCommandProcessor::Destroy() { agent_->ReleaseQueue(this); }
+
+bool HwAqlCommandProcessor::Reset() {
+  // The CP keeps its own copy of the indices, they continue from their
+  // current values rather than restarting at zero.
+  uint64_t write = LoadWriteIndexAcquire();
+  if (LoadReadIndexAcquire() != write) return false;
+
+  // Every packet was consumed, mark the slots as never written again.
+  const uint32_t size = amd_queue_.hsa_queue.size;
+  for (uint32_t pkt_id = 0; pkt_id < size; ++pkt_id) {
+    ((uint32_t*)ring_buf_)[16 * pkt_id] = HSA_PACKET_TYPE_ALWAYS_RESERVED;
+  }
+
+  Queue::Invalidate();
+  return true;
+}
+
+void HwAqlCommandProcessor::Reuse() {
+  amd_queue_.hsa_queue.id = core::Runtime::runtime_singleton_->GetQueueId();
+  Queue::Validate();
+}
+
 uint64_t HwAqlCommandProcessor::LoadReadIndexAcquire() {
   return DispatchIdToNumPackets(
       atomic::Load(&amd_queue_.read_dispatch_id, std::memory_order_acquire));
@@ -407,55 +431,11 @@ void HwAqlCommandProcessor::AllocRegisteredRingBuffer(
   ring_buf_alloc_bytes_ = 2 * ring_buf_phys_size_bytes;
 
 #ifdef __linux__
-  // Create a system-unique shared memory path for this thread.
-  char ring_buf_shm_path[16];
-  pid_t sys_unique_tid = pid_t(syscall(__NR_gettid));
-  sprintf(ring_buf_shm_path, "/%u", sys_unique_tid);
-
-  int ring_buf_shm_fd = -1;
-  void* reserve_va = NULL;
-
-  do {
-    // Create a shared memory object to back the ring buffer.
-    ring_buf_shm_fd = shm_open(ring_buf_shm_path, O_CREAT | O_RDWR | O_EXCL,
-                               S_IRUSR | S_IWUSR);
-    if (ring_buf_shm_fd == -1) {
-      break;
-    }
-    if (ftruncate(ring_buf_shm_fd, ring_buf_phys_size_bytes) == -1) {
-      break;
-    }
-
-    // Reserve a VA range twice the size of the physical backing store.
-    reserve_va = mmap(NULL, ring_buf_alloc_bytes_, PROT_NONE,
-                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-
-    // Remap the lower and upper halves of the VA range.
-    // Map both halves to the shared memory backing store.
-    void* ring_buf_lower_half =
-        mmap(reserve_va, ring_buf_phys_size_bytes, PROT_READ | PROT_WRITE,
-             MAP_SHARED | MAP_FIXED, ring_buf_shm_fd, 0);
-
-    void* ring_buf_upper_half =
-        mmap((void*)(uintptr_t(reserve_va) + ring_buf_phys_size_bytes),
-             ring_buf_phys_size_bytes, PROT_READ | PROT_WRITE,
-             MAP_SHARED | MAP_FIXED, ring_buf_shm_fd, 0);
-
-    // Release explicit reference to shared memory object.
-    shm_unlink(ring_buf_shm_path);
-    close(ring_buf_shm_fd);
-
-    // Successfully created mapping.
-    ring_buf_ = ring_buf_lower_half;
-    return;
-  } while (false);
-
-  // Resource cleanup on failure.
-  if (reserve_va) munmap(reserve_va, ring_buf_alloc_bytes_);
-  if (ring_buf_shm_fd != -1) {
-    shm_unlink(ring_buf_shm_path);
-    close(ring_buf_shm_fd);
-  }
+  // Rings of whole huge pages try huge pages first, which fails cleanly at
+  // mmap time when the system has none to spare.
+  bool huge_pages = (ring_buf_phys_size_bytes % os::kHugePageSize) == 0;
+  if (huge_pages && MapRingBuffer(ring_buf_phys_size_bytes, true)) return;
+  MapRingBuffer(ring_buf_phys_size_bytes, false);
 #endif
 #ifdef _WIN32
   HANDLE ring_buf_mapping = INVALID_HANDLE_VALUE;
@@ -554,6 +534,51 @@ void HwAqlCommandProcessor::FreeRegisteredRingBuffer() {
   ring_buf_alloc_bytes_ = 0;
 }
 
+#if QUEUE_FULL_WORKAROUND && defined(__linux__)
+bool HwAqlCommandProcessor::MapRingBuffer(uint32_t phys_size_bytes,
+                                          bool huge_pages) {
+  // Anonymous backing store, released once both halves are unmapped.
+  int fd = os::CreateSharedMemory(phys_size_bytes, huge_pages);
+  if (fd == -1) return false;
+
+  // Reserve a VA range twice the size of the backing store, aligned to the
+  // page size of the backing store.
+  const size_t align = (huge_pages) ? os::kHugePageSize : 0;
+  const size_t reserve_bytes = ring_buf_alloc_bytes_ + align;
+  void* reserve_va = mmap(NULL, reserve_bytes, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserve_va == MAP_FAILED) {
+    os::CloseSharedMemory(fd);
+    return false;
+  }
+  uintptr_t base = uintptr_t(reserve_va);
+  if (align != 0) {
+    // Trim the unaligned head and the remaining tail of the reservation.
+    uintptr_t aligned = AlignUp(base, align);
+    size_t head_bytes = aligned - base;
+    if (head_bytes != 0) munmap(reserve_va, head_bytes);
+    munmap((void*)(aligned + ring_buf_alloc_bytes_), align - head_bytes);
+    base = aligned;
+  }
+
+  // Map the lower and upper halves of the VA range to the backing store.
+  void* lower = mmap((void*)base, phys_size_bytes, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_FIXED, fd, 0);
+  void* upper =
+      mmap((void*)(base + phys_size_bytes), phys_size_bytes,
+           PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+  os::CloseSharedMemory(fd);
+
+  if (lower == MAP_FAILED || upper == MAP_FAILED) {
+    munmap((void*)base, ring_buf_alloc_bytes_);
+    return false;
+  }
+
+  ring_buf_ = lower;
+  return true;
+}
+#endif
+
 uint64_t HwAqlCommandProcessor::DispatchIdToNumPackets(uint64_t dispatch_id) {
   // Gfx7/Gfx8 microcode interprets amd_queue_t.read_dispatch_id and
   // .write_dispatch_id as counts in DWORDs, not AQL packets.
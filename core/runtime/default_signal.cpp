@@ -46,86 +46,108 @@
 
 #include "core/inc/default_signal.h"
 
+#include "core/util/os.h"
+
 namespace core {
 
+static_assert(sizeof(DefaultSignal) <= SignalPool::kBlockSize,
+              "DefaultSignal does not fit in a signal pool block.");
+
 DefaultSignal::DefaultSignal(hsa_signal_value_t initial_value)
-    : Signal(initial_value), invalid_(false), waiting_(0) {
+    : Signal(initial_value) {
   signal_.type = kHsaSignalAmd;
   signal_.event_mailbox_ptr = NULL;
-  hsa_memory_register(this, sizeof(DefaultSignal));
 }
 
-DefaultSignal::~DefaultSignal() {
-  invalid_ = true;
-  while (waiting_ != 0)
-    ;
-  hsa_memory_deregister(this, sizeof(DefaultSignal));
-}
+DefaultSignal::~DefaultSignal() { invalid_ = true; }
 
 hsa_signal_value_t DefaultSignal::LoadRelaxed() {
-  return hsa_signal_value_t(
-      atomic::Load(&signal_.value, std::memory_order_relaxed));
+  return Load<std::memory_order_relaxed>();
 }
 
 hsa_signal_value_t DefaultSignal::LoadAcquire() {
-  return hsa_signal_value_t(
-      atomic::Load(&signal_.value, std::memory_order_acquire));
+  return Load<std::memory_order_acquire>();
 }
 
 void DefaultSignal::StoreRelaxed(hsa_signal_value_t value) {
-  atomic::Store(&signal_.value, int64_t(value), std::memory_order_relaxed);
+  Store<std::memory_order_relaxed>(value);
 }
 
 void DefaultSignal::StoreRelease(hsa_signal_value_t value) {
-  atomic::Store(&signal_.value, int64_t(value), std::memory_order_release);
+  Store<std::memory_order_release>(value);
 }
 
 hsa_signal_value_t DefaultSignal::WaitRelaxed(hsa_signal_condition_t condition,
                                               hsa_signal_value_t compare_value,
                                               uint64_t timeout,
                                               hsa_wait_expectancy_t wait_hint) {
-  atomic::Increment(&waiting_);
-  MAKE_SCOPE_GUARD([&]() { atomic::Decrement(&waiting_); });
-  bool condition_met = false;
+  if (!IsValidCondition(condition)) return 0;
+
+  // Publish the waiter before sampling the value, pairs with NotifyIfWaiting.
+  AddWaiter();
+  MAKE_SCOPE_GUARD([&]() { RemoveWaiter(); });
+  WaitRecord record(this);
+  WaitPolicy policy(wait_hint, &wait_history_);
+  SpinWait spin;
+
+  // Waiters park on the low word of the signal value. A write confining its
+  // change to the high word leaves the low word equal to the parked value, so
+  // the futex keeps sleeping. Such a change is only seen once the park times
+  // out, which bounds the added latency by kMaxParkNs.
+  volatile uint32_t* value_word = (volatile uint32_t*)&signal_.value;
+
+  // Infinite waits never need the system timestamp.
+  const bool infinite = (timeout == uint64_t(-1));
+  const SystemClock& clock = Runtime::runtime_singleton_->system_clock();
+  uint64_t start_time = 0, sys_time;
+  if (!infinite) start_time = clock.Timestamp();
+
+  // Parks are bounded and back off since writes from a device do not wake the
+  // futex, only writes made through this object do.
+  const uint64_t kMinParkNs = 20000;
+  const uint64_t kMaxParkNs = 1000000;
+  uint64_t park_ns = kMinParkNs;
+
   int64_t value;
+  while (true) {
+    if (invalid_) return 0;
 
-  uint64_t start_time, sys_time;
-  hsa_system_get_info(HSA_SYSTEM_INFO_TIMESTAMP, &start_time);
+    value = atomic::Load(&signal_.value, std::memory_order_relaxed);
 
-  while (true) {
-    hsa_system_get_info(HSA_SYSTEM_INFO_TIMESTAMP, &sys_time);
-    if (sys_time - start_time > timeout) {
-      value = atomic::Load(&signal_.value, std::memory_order_relaxed);
+    if (CheckCondition(condition, hsa_signal_value_t(value), compare_value)) {
+      policy.Satisfied();
       return hsa_signal_value_t(value);
     }
 
-    for (int i = 0; i < 10000; i++) {
-      if (invalid_) return 0;
-
-      value = atomic::Load(&signal_.value, std::memory_order_relaxed);
-
-      switch (condition) {
-        case HSA_EQ: {
-          condition_met = (value == compare_value);
-          break;
-        }
-        case HSA_NE: {
-          condition_met = (value != compare_value);
-          break;
-        }
-        case HSA_GTE: {
-          condition_met = (value >= compare_value);
-          break;
-        }
-        case HSA_LT: {
-          condition_met = (value < compare_value);
-          break;
-        }
-        default:
-          return 0;
+    WaitPolicy::Phase phase = policy.Next();
+    if (phase == WaitPolicy::kSpin) {
+      record.Spin();
+      spin.Wait(&signal_.value, value);
+      continue;
+    }
+
+    uint64_t remaining_ns = kMaxParkNs;
+    if (!infinite) {
+      sys_time = clock.Timestamp();
+      if (sys_time - start_time > timeout) {
+        record.Timeout();
+        value = atomic::Load(&signal_.value, std::memory_order_relaxed);
+        return hsa_signal_value_t(value);
       }
-      if (condition_met) return hsa_signal_value_t(value);
+      remaining_ns = clock.TicksToNs(timeout - (sys_time - start_time));
     }
+
+    if (phase == WaitPolicy::kYield) {
+      os::YieldThread();
+      continue;
+    }
+
+    record.BlockBegin();
+    bool notified = os::WaitOnAddress(
+        value_word, uint32_t(value),
+        Max(Min(park_ns, remaining_ns), uint64_t(1)));
+    record.BlockEnd(notified);
+    park_ns = Min(park_ns * 2, kMaxParkNs);
   }
 }
 
@@ -140,131 +162,119 @@ hsa_signal_value_t DefaultSignal::WaitAcquire(hsa_signal_condition_t condition,
 }
 
 void DefaultSignal::AndRelaxed(hsa_signal_value_t value) {
-  atomic::And(&signal_.value, int64_t(value), std::memory_order_relaxed);
+  Modify<kSignalOpAnd, std::memory_order_relaxed>(value);
 }
 
 void DefaultSignal::AndAcquire(hsa_signal_value_t value) {
-  atomic::And(&signal_.value, int64_t(value), std::memory_order_acquire);
+  Modify<kSignalOpAnd, std::memory_order_acquire>(value);
 }
 
 void DefaultSignal::AndRelease(hsa_signal_value_t value) {
-  atomic::And(&signal_.value, int64_t(value), std::memory_order_release);
+  Modify<kSignalOpAnd, std::memory_order_release>(value);
 }
 
 void DefaultSignal::AndAcqRel(hsa_signal_value_t value) {
-  atomic::And(&signal_.value, int64_t(value), std::memory_order_acq_rel);
+  Modify<kSignalOpAnd, std::memory_order_acq_rel>(value);
 }
 
 void DefaultSignal::OrRelaxed(hsa_signal_value_t value) {
-  atomic::Or(&signal_.value, int64_t(value), std::memory_order_relaxed);
+  Modify<kSignalOpOr, std::memory_order_relaxed>(value);
 }
 
 void DefaultSignal::OrAcquire(hsa_signal_value_t value) {
-  atomic::Or(&signal_.value, int64_t(value), std::memory_order_acquire);
+  Modify<kSignalOpOr, std::memory_order_acquire>(value);
 }
 
 void DefaultSignal::OrRelease(hsa_signal_value_t value) {
-  atomic::Or(&signal_.value, int64_t(value), std::memory_order_release);
+  Modify<kSignalOpOr, std::memory_order_release>(value);
 }
 
 void DefaultSignal::OrAcqRel(hsa_signal_value_t value) {
-  atomic::Or(&signal_.value, int64_t(value), std::memory_order_acq_rel);
+  Modify<kSignalOpOr, std::memory_order_acq_rel>(value);
 }
 
 void DefaultSignal::XorRelaxed(hsa_signal_value_t value) {
-  atomic::Xor(&signal_.value, int64_t(value), std::memory_order_relaxed);
+  Modify<kSignalOpXor, std::memory_order_relaxed>(value);
 }
 
 void DefaultSignal::XorAcquire(hsa_signal_value_t value) {
-  atomic::Xor(&signal_.value, int64_t(value), std::memory_order_acquire);
+  Modify<kSignalOpXor, std::memory_order_acquire>(value);
 }
 
 void DefaultSignal::XorRelease(hsa_signal_value_t value) {
-  atomic::Xor(&signal_.value, int64_t(value), std::memory_order_release);
+  Modify<kSignalOpXor, std::memory_order_release>(value);
 }
 
 void DefaultSignal::XorAcqRel(hsa_signal_value_t value) {
-  atomic::Xor(&signal_.value, int64_t(value), std::memory_order_acq_rel);
+  Modify<kSignalOpXor, std::memory_order_acq_rel>(value);
 }
 
 void DefaultSignal::AddRelaxed(hsa_signal_value_t value) {
-  atomic::Add(&signal_.value, int64_t(value), std::memory_order_relaxed);
+  Modify<kSignalOpAdd, std::memory_order_relaxed>(value);
 }
 
 void DefaultSignal::AddAcquire(hsa_signal_value_t value) {
-  atomic::Add(&signal_.value, int64_t(value), std::memory_order_acquire);
+  Modify<kSignalOpAdd, std::memory_order_acquire>(value);
 }
 
 void DefaultSignal::AddRelease(hsa_signal_value_t value) {
-  atomic::Add(&signal_.value, int64_t(value), std::memory_order_release);
+  Modify<kSignalOpAdd, std::memory_order_release>(value);
 }
 
 void DefaultSignal::AddAcqRel(hsa_signal_value_t value) {
-  atomic::Add(&signal_.value, int64_t(value), std::memory_order_acq_rel);
+  Modify<kSignalOpAdd, std::memory_order_acq_rel>(value);
 }
 
 void DefaultSignal::SubRelaxed(hsa_signal_value_t value) {
-  atomic::Sub(&signal_.value, int64_t(value), std::memory_order_relaxed);
+  Modify<kSignalOpSub, std::memory_order_relaxed>(value);
 }
 
 void DefaultSignal::SubAcquire(hsa_signal_value_t value) {
-  atomic::Sub(&signal_.value, int64_t(value), std::memory_order_acquire);
+  Modify<kSignalOpSub, std::memory_order_acquire>(value);
 }
 
 void DefaultSignal::SubRelease(hsa_signal_value_t value) {
-  atomic::Sub(&signal_.value, int64_t(value), std::memory_order_release);
+  Modify<kSignalOpSub, std::memory_order_release>(value);
 }
 
 void DefaultSignal::SubAcqRel(hsa_signal_value_t value) {
-  atomic::Sub(&signal_.value, int64_t(value), std::memory_order_acq_rel);
+  Modify<kSignalOpSub, std::memory_order_acq_rel>(value);
 }
 
 hsa_signal_value_t DefaultSignal::ExchRelaxed(hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Exchange(&signal_.value, int64_t(value),
-                                             std::memory_order_relaxed));
+  return Exchange<std::memory_order_relaxed>(value);
 }
 
 hsa_signal_value_t DefaultSignal::ExchAcquire(hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Exchange(&signal_.value, int64_t(value),
-                                             std::memory_order_acquire));
+  return Exchange<std::memory_order_acquire>(value);
 }
 
 hsa_signal_value_t DefaultSignal::ExchRelease(hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Exchange(&signal_.value, int64_t(value),
-                                             std::memory_order_release));
+  return Exchange<std::memory_order_release>(value);
 }
 
 hsa_signal_value_t DefaultSignal::ExchAcqRel(hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Exchange(&signal_.value, int64_t(value),
-                                             std::memory_order_acq_rel));
+  return Exchange<std::memory_order_acq_rel>(value);
 }
 
 hsa_signal_value_t DefaultSignal::CasRelaxed(hsa_signal_value_t expected,
                                              hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Cas(&signal_.value, int64_t(value),
-                                        int64_t(expected),
-                                        std::memory_order_relaxed));
+  return CompareExchange<std::memory_order_relaxed>(expected, value);
 }
 
 hsa_signal_value_t DefaultSignal::CasAcquire(hsa_signal_value_t expected,
                                              hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Cas(&signal_.value, int64_t(value),
-                                        int64_t(expected),
-                                        std::memory_order_acquire));
+  return CompareExchange<std::memory_order_acquire>(expected, value);
 }
 
 hsa_signal_value_t DefaultSignal::CasRelease(hsa_signal_value_t expected,
                                              hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Cas(&signal_.value, int64_t(value),
-                                        int64_t(expected),
-                                        std::memory_order_release));
+  return CompareExchange<std::memory_order_release>(expected, value);
 }
 
 hsa_signal_value_t DefaultSignal::CasAcqRel(hsa_signal_value_t expected,
                                             hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Cas(&signal_.value, int64_t(value),
-                                        int64_t(expected),
-                                        std::memory_order_acq_rel));
+  return CompareExchange<std::memory_order_acq_rel>(expected, value);
 }
 
 }  // namespace core
\ No newline at end of file
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "core/inc/event_pool.h"
+
+#include "inc/hsa.h"
+
+namespace core {
+
+EventPool::EventPool() {}
+
+EventPool::~EventPool() { Clear(); }
+
+HsaEvent* EventPool::Alloc() {
+  ScopedAcquire<KernelMutex> lock(&lock_);
+  if (free_.empty() && !Grow()) return NULL;
+  HsaEvent* event = free_.back();
+  free_.pop_back();
+  return event;
+}
+
+void EventPool::Free(HsaEvent* event) {
+  if (event == NULL) return;
+  {
+    ScopedAcquire<KernelMutex> lock(&lock_);
+    if (free_.size() < kMaxIdle) {
+      free_.push_back(event);
+      return;
+    }
+  }
+  hsaKmtDestroyEvent(event);
+}
+
+void EventPool::Clear() {
+  ScopedAcquire<KernelMutex> lock(&lock_);
+  for (size_t i = 0; i < free_.size(); i++) hsaKmtDestroyEvent(free_[i]);
+  free_.clear();
+}
+
+bool EventPool::Grow() {
+  // The event is not tied to any one signal value. KFD signal events do not
+  // use the sync variable.
+  HsaEventDescriptor event_descriptor;
+#ifdef __linux__
+  event_descriptor.EventType = HSA_EVENTTYPE_SIGNAL;
+#else
+  event_descriptor.EventType = HSA_EVENTTYPE_QUEUE_EVENT;
+#endif
+  event_descriptor.SyncVar.SyncVar.UserData = NULL;
+  event_descriptor.SyncVar.SyncVarSize = sizeof(hsa_signal_value_t);
+  event_descriptor.NodeId = 0;
+
+  for (uint32_t i = 0; i < kGrowCount; i++) {
+    HsaEvent* event;
+    if (hsaKmtCreateEvent(&event_descriptor, false, false, &event) !=
+        HSAKMT_STATUS_SUCCESS)
+      break;
+    free_.push_back(event);
+  }
+  return !free_.empty();
+}
+
+}  // namespace core
@@ -46,11 +46,24 @@
 
 #include "core/inc/host_queue.h"
 
+#include <string.h>
+
+#include <limits>
+
 #include "core/inc/runtime.h"
 #include "core/util/utils.h"
 
 namespace core {
-HostQueue::HostQueue(uint32_t ring_size) : size_(ring_size), active_(false) {
+thread_local HostQueue* HostQueue::executing_queue_ = NULL;
+
+HostQueue::HostQueue(uint32_t ring_size, hsa_agent_t agent,
+                     HsaEventCallback callback)
+    : size_(ring_size),
+      active_(false),
+      callback_(callback),
+      executor_(NULL),
+      exit_(false),
+      self_destroy_(false) {
   hsa_memory_register(this, sizeof(HostQueue));
 
   ring_ = _aligned_malloc(size_ * sizeof(hsa_agent_dispatch_packet_t),
@@ -62,7 +75,18 @@ HostQueue::HostQueue(uint32_t ring_size) : size_(ring_size), active_(false) {
     _aligned_free(ring_);
   });
 
-  if (hsa_signal_create(-1, 0, NULL, &signal_) != HSA_STATUS_SUCCESS) return;
+  // Slots are free until a producer publishes a packet header.
+  AqlPacket* packets = reinterpret_cast<AqlPacket*>(ring_);
+  for (uint32_t i = 0; i < size_; i++) {
+    memset(&packets[i], 0, sizeof(AqlPacket));
+    packets[i].dispatch.header.type = HSA_PACKET_TYPE_INVALID;
+  }
+
+  // Only this queue's agent, the executor thread, waits on the doorbell. As a
+  // host consumer it gets the configured signal kind, see
+  // Signal::HostMayWait.
+  if (hsa_signal_create(-1, 1, &agent, &signal_) != HSA_STATUS_SUCCESS) return;
+  MAKE_NAMED_SCOPE_GUARD(signal_guard, [&]() { hsa_signal_destroy(signal_); });
 
   amd_queue_.hsa_queue.base_address = reinterpret_cast<uint64_t>(ring_);
   amd_queue_.hsa_queue.size = size_;
@@ -79,15 +103,145 @@ HostQueue::HostQueue(uint32_t ring_size) : size_(ring_size), active_(false) {
   amd_queue_.hsa_queue.queue_features = HSA_QUEUE_FEATURE_AGENT_DISPATCH;
   amd_queue_.enable_profiling = 0;
 
+  executor_ = os::CreateThread(ExecutorLoop, this);
+  if (executor_ == NULL) return;
+
   active_ = true;
+  signal_guard.Dismiss();
   ring_guard.Dismiss();
 }
 
 HostQueue::~HostQueue() {
+  if (!active_) {
+    hsa_memory_deregister(this, sizeof(HostQueue));
+    return;
+  }
+
+  // Stop the executor, any value satisfies its doorbell wait. An executor
+  // deleting its own queue has already stopped.
+  if (!self_destroy_) {
+    exit_ = true;
+    hsa_signal_store_release(signal_,
+                             std::numeric_limits<hsa_signal_value_t>::max());
+    os::WaitForThread(executor_);
+  }
+
   hsa_signal_destroy(signal_);
   hsa_memory_deregister(ring_, size_ * sizeof(hsa_agent_dispatch_packet_t));
   _aligned_free(ring_);
   hsa_memory_deregister(this, sizeof(HostQueue));
 }
 
-}  // namespace core
\ No newline at end of file
+void HostQueue::Destroy() {
+  if (executing_queue_ != this) {
+    delete this;
+    return;
+  }
+
+  // Called by a handler on the executor, which stops once the handler
+  // returns and deletes the queue from ExecutorLoop.
+  self_destroy_ = true;
+  exit_ = true;
+}
+
+void HostQueue::ExecutorLoop(void* arg) {
+  HostQueue* queue = reinterpret_cast<HostQueue*>(arg);
+  executing_queue_ = queue;
+  queue->Execute();
+  executing_queue_ = NULL;
+
+  if (queue->self_destroy_) {
+    // Nobody joins this thread.
+    os::CloseThread(queue->executor_);
+    delete queue;
+  }
+}
+
+void HostQueue::Execute() {
+  AqlPacket* packets = reinterpret_cast<AqlPacket*>(ring_);
+  const uint64_t mask = size_ - 1;
+  uint64_t read = 0;
+
+  while (true) {
+    // Sleep until a producer rings the doorbell for this packet or a later
+    // one.
+    hsa_signal_value_t doorbell = hsa_signal_wait_acquire(
+        signal_, HSA_GTE, hsa_signal_value_t(read), uint64_t(-1),
+        HSA_WAIT_EXPECTANCY_UNKNOWN);
+    if (exit_) return;
+
+    // Execute every published packet. A later packet's doorbell may arrive
+    // before this one's header is written, then let its producer run.
+    bool executed = false;
+    while (true) {
+      AqlPacket* packet = &packets[read & mask];
+      uint16_t header =
+          atomic::Load(reinterpret_cast<volatile uint16_t*>(packet),
+                       std::memory_order_acquire);
+      // Same test as AqlPacket::IsValid, on the sampled header.
+      if (((header & 0xFF) & ~1) == 0) break;
+
+      ExecutePacket(packet, header);
+      if (exit_) return;
+
+      // Free the slot before publishing the read index.
+      atomic::Store(reinterpret_cast<volatile uint16_t*>(packet),
+                    uint16_t(HSA_PACKET_TYPE_INVALID),
+                    std::memory_order_relaxed);
+      StoreReadIndexRelease(++read);
+      executed = true;
+    }
+    if (!executed && doorbell >= hsa_signal_value_t(read)) os::YieldThread();
+  }
+}
+
+void HostQueue::ExecutePacket(AqlPacket* packet, uint16_t header) {
+  hsa_signal_t completion_signal = 0;
+
+  switch (header & 0xFF) {
+    case HSA_PACKET_TYPE_AGENT_DISPATCH: {
+      const hsa_agent_dispatch_packet_t& dispatch = packet->agent;
+      hsa_amd_agent_dispatch_handler handler;
+      void* data;
+      if (Runtime::runtime_singleton_->GetAgentDispatchHandler(
+              dispatch.type, &handler, &data)) {
+        handler(&dispatch, data);
+      } else if (callback_ != NULL) {
+        callback_(HSA_STATUS_ERROR_INVALID_PACKET_FORMAT, Convert(this));
+      }
+      completion_signal = dispatch.completion_signal;
+      break;
+    }
+    case HSA_PACKET_TYPE_BARRIER: {
+      const hsa_barrier_packet_t& barrier = packet->barrier;
+      for (int i = 0; i < 5; i++) {
+        if (barrier.dep_signal[i] == 0) continue;
+        if (!WaitDependency(barrier.dep_signal[i])) return;
+      }
+      completion_signal = barrier.completion_signal;
+      break;
+    }
+    default: {
+      // Kernel dispatches cannot execute on the host.
+      if (callback_ != NULL)
+        callback_(HSA_STATUS_ERROR_INVALID_PACKET_FORMAT, Convert(this));
+      completion_signal = packet->dispatch.completion_signal;
+      break;
+    }
+  }
+
+  if (completion_signal != 0) hsa_signal_subtract_release(completion_signal, 1);
+}
+
+bool HostQueue::WaitDependency(hsa_signal_t signal) {
+  // Bounded waits let the destructor stop an executor stuck on a dependency.
+  const SystemClock& clock = Runtime::runtime_singleton_->system_clock();
+  const uint64_t kExitPollTicks = Max(clock.Frequency() / 1000, uint64_t(1));
+  while (hsa_signal_wait_acquire(signal, HSA_EQ, 0, kExitPollTicks,
+                                 HSA_WAIT_EXPECTANCY_UNKNOWN) != 0) {
+    if (exit_) return false;
+  }
+  return true;
+}
+
+}  // namespace core
@@ -53,6 +53,7 @@
 #include "core/inc/queue.h"
 #include "core/inc/signal.h"
 #include "core/inc/default_signal.h"
+#include "core/inc/hybrid_signal.h"
 #include "core/inc/interrupt_signal.h"
 
 template <class T>
@@ -204,7 +205,7 @@ hsa_status_t HSA_API
 hsa_status_t HSA_API hsa_queue_destroy(hsa_queue_t* queue) {
   core::Queue* cmd_queue = core::Queue::Convert(queue);
   IS_VALID(cmd_queue);
-  delete cmd_queue;
+  cmd_queue->Destroy();
   return HSA_STATUS_SUCCESS;
 }
 
@@ -508,9 +509,13 @@ hsa_status_t HSA_API
   IS_BAD_PTR(hsa_signal);
   core::Signal* ret;
   if (num_consumers != 0) IS_BAD_PTR(consumers);
-  if (core::g_use_interrupt_wait)
+  // Signals only consumed by devices never need a KFD event.
+  const bool host_waits = core::Signal::HostMayWait(num_consumers, consumers);
+  if (host_waits && core::g_use_interrupt_wait)
     ret =
         core::InterruptSignal::Create(initial_value, num_consumers, consumers);
+  else if (host_waits && core::g_use_hybrid_wait)
+    ret = new core::HybridSignal(initial_value);
   else
     ret = new core::DefaultSignal(initial_value);
   CHECK_ALLOC(ret);
@@ -521,19 +526,23 @@ hsa_status_t HSA_API
 hsa_status_t HSA_API hsa_signal_destroy(hsa_signal_t hsa_signal) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   IS_VALID(signal);
-  delete signal;
+  signal->Destroy();
   return HSA_STATUS_SUCCESS;
 }
 
 hsa_signal_value_t HSA_API hsa_signal_load_relaxed(hsa_signal_t hsa_signal) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->Load<std::memory_order_relaxed>();
   return signal->LoadRelaxed();
 }
 
 hsa_signal_value_t HSA_API hsa_signal_load_acquire(hsa_signal_t hsa_signal) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->Load<std::memory_order_acquire>();
   return signal->LoadAcquire();
 }
 
@@ -541,14 +550,20 @@ void HSA_API hsa_signal_store_relaxed(hsa_signal_t hsa_signal,
                                       hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->StoreRelaxed(value);
+  if (signal->IsMemorySignal())
+    signal->Store<std::memory_order_relaxed>(value);
+  else
+    signal->StoreRelaxed(value);
 }
 
 void HSA_API hsa_signal_store_release(hsa_signal_t hsa_signal,
                                       hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->StoreRelease(value);
+  if (signal->IsMemorySignal())
+    signal->Store<std::memory_order_release>(value);
+  else
+    signal->StoreRelease(value);
 }
 
 hsa_signal_value_t HSA_API
@@ -579,90 +594,128 @@ void HSA_API
     hsa_signal_and_relaxed(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->AndRelaxed(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpAnd, std::memory_order_relaxed>(value);
+  else
+    signal->AndRelaxed(value);
 }
 
 void HSA_API
     hsa_signal_and_acquire(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->AndAcquire(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpAnd, std::memory_order_acquire>(value);
+  else
+    signal->AndAcquire(value);
 }
 
 void HSA_API
     hsa_signal_and_release(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->AndRelease(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpAnd, std::memory_order_release>(value);
+  else
+    signal->AndRelease(value);
 }
 
 void HSA_API
     hsa_signal_and_acq_rel(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->AndAcqRel(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpAnd, std::memory_order_acq_rel>(value);
+  else
+    signal->AndAcqRel(value);
 }
 
 void HSA_API
     hsa_signal_or_relaxed(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->OrRelaxed(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpOr, std::memory_order_relaxed>(value);
+  else
+    signal->OrRelaxed(value);
 }
 
 void HSA_API
     hsa_signal_or_acquire(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->OrAcquire(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpOr, std::memory_order_acquire>(value);
+  else
+    signal->OrAcquire(value);
 }
 
 void HSA_API
     hsa_signal_or_release(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->OrRelease(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpOr, std::memory_order_release>(value);
+  else
+    signal->OrRelease(value);
 }
 
 void HSA_API
     hsa_signal_or_acq_rel(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->OrAcqRel(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpOr, std::memory_order_acq_rel>(value);
+  else
+    signal->OrAcqRel(value);
 }
 
 void HSA_API
     hsa_signal_xor_relaxed(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->XorRelaxed(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpXor, std::memory_order_relaxed>(value);
+  else
+    signal->XorRelaxed(value);
 }
 
 void HSA_API
     hsa_signal_xor_acquire(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->XorAcquire(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpXor, std::memory_order_acquire>(value);
+  else
+    signal->XorAcquire(value);
 }
 
 void HSA_API
     hsa_signal_xor_release(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->XorRelease(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpXor, std::memory_order_release>(value);
+  else
+    signal->XorRelease(value);
 }
 
 void HSA_API
     hsa_signal_xor_acq_rel(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->XorAcqRel(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpXor, std::memory_order_acq_rel>(value);
+  else
+    signal->XorAcqRel(value);
 }
 
 void HSA_API
     hsa_signal_add_relaxed(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->Modify<core::kSignalOpAdd, std::memory_order_relaxed>(value);
   return signal->AddRelaxed(value);
 }
 
@@ -670,49 +723,70 @@ void HSA_API
     hsa_signal_add_acquire(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->AddAcquire(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpAdd, std::memory_order_acquire>(value);
+  else
+    signal->AddAcquire(value);
 }
 
 void HSA_API
     hsa_signal_add_release(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->AddRelease(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpAdd, std::memory_order_release>(value);
+  else
+    signal->AddRelease(value);
 }
 
 void HSA_API
     hsa_signal_add_acq_rel(hsa_signal_t hsa_signal, hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->AddAcqRel(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpAdd, std::memory_order_acq_rel>(value);
+  else
+    signal->AddAcqRel(value);
 }
 
 void HSA_API hsa_signal_subtract_relaxed(hsa_signal_t hsa_signal,
                                          hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->SubRelaxed(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpSub, std::memory_order_relaxed>(value);
+  else
+    signal->SubRelaxed(value);
 }
 
 void HSA_API hsa_signal_subtract_acquire(hsa_signal_t hsa_signal,
                                          hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->SubAcquire(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpSub, std::memory_order_acquire>(value);
+  else
+    signal->SubAcquire(value);
 }
 
 void HSA_API hsa_signal_subtract_release(hsa_signal_t hsa_signal,
                                          hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->SubRelease(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpSub, std::memory_order_release>(value);
+  else
+    signal->SubRelease(value);
 }
 
 void HSA_API hsa_signal_subtract_acq_rel(hsa_signal_t hsa_signal,
                                          hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
-  signal->SubAcqRel(value);
+  if (signal->IsMemorySignal())
+    signal->Modify<core::kSignalOpSub, std::memory_order_acq_rel>(value);
+  else
+    signal->SubAcqRel(value);
 }
 
 hsa_signal_value_t HSA_API
@@ -720,6 +794,8 @@ hsa_signal_value_t HSA_API
                                 hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->Exchange<std::memory_order_relaxed>(value);
   return signal->ExchRelaxed(value);
 }
 
@@ -728,6 +804,8 @@ hsa_signal_value_t HSA_API
                                 hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->Exchange<std::memory_order_acquire>(value);
   return signal->ExchAcquire(value);
 }
 
@@ -736,6 +814,8 @@ hsa_signal_value_t HSA_API
                                 hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->Exchange<std::memory_order_release>(value);
   return signal->ExchRelease(value);
 }
 
@@ -744,6 +824,8 @@ hsa_signal_value_t HSA_API
                                 hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->Exchange<std::memory_order_acq_rel>(value);
   return signal->ExchAcqRel(value);
 }
 
@@ -752,6 +834,8 @@ hsa_signal_value_t HSA_API hsa_signal_cas_relaxed(hsa_signal_t hsa_signal,
                                                   hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->CompareExchange<std::memory_order_relaxed>(expected, value);
   return signal->CasRelaxed(expected, value);
 }
 
@@ -760,6 +844,8 @@ hsa_signal_value_t HSA_API hsa_signal_cas_acquire(hsa_signal_t hsa_signal,
                                                   hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->CompareExchange<std::memory_order_acquire>(expected, value);
   return signal->CasAcquire(expected, value);
 }
 
@@ -768,6 +854,8 @@ hsa_signal_value_t HSA_API hsa_signal_cas_release(hsa_signal_t hsa_signal,
                                                   hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->CompareExchange<std::memory_order_release>(expected, value);
   return signal->CasRelease(expected, value);
 }
 
@@ -776,6 +864,8 @@ hsa_signal_value_t HSA_API hsa_signal_cas_acq_rel(hsa_signal_t hsa_signal,
                                                   hsa_signal_value_t value) {
   core::Signal* signal = core::Signal::Convert(hsa_signal);
   assert(IsValid(signal));
+  if (signal->IsMemorySignal())
+    return signal->CompareExchange<std::memory_order_acq_rel>(expected, value);
   return signal->CasAcqRel(expected, value);
 }
 
@@ -49,6 +49,10 @@
 #include "core/inc/agent.h"
 #include "core/inc/amd_gpu_agent.h"
 #include "core/inc/hsa_code_unit.h"
+#include "core/inc/default_signal.h"
+#include "core/inc/hybrid_signal.h"
+#include "core/inc/interrupt_signal.h"
+#include "core/inc/ipc_signal.h"
 #include "core/inc/signal.h"
 
 template <class T>
@@ -165,6 +169,353 @@ hsa_status_t HSA_API hsa_ext_get_dispatch_times(hsa_agent_t agent_handle,
   return HSA_STATUS_SUCCESS;
 }
 
+//===----------------------------------------------------------------------===//
+// AMD Queue APIs.                                                            //
+//===----------------------------------------------------------------------===//
+
+hsa_status_t HSA_API
+    hsa_amd_queue_submit(hsa_queue_t* queue, const void* packets,
+                         uint32_t count) {
+  IS_BAD_PTR(queue);
+
+  core::Queue* cmd_queue = core::Queue::Convert(queue);
+
+  IS_VALID(cmd_queue);
+
+  if (count == 0) return HSA_STATUS_SUCCESS;
+
+  IS_BAD_PTR(packets);
+
+  if (count > queue->size) return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+
+  cmd_queue->Submit(reinterpret_cast<const core::AqlPacket*>(packets), count);
+  return HSA_STATUS_SUCCESS;
+}
+
+//===----------------------------------------------------------------------===//
+// AMD Agent Dispatch APIs.                                                   //
+//===----------------------------------------------------------------------===//
+
+hsa_status_t HSA_API
+    hsa_amd_agent_dispatch_register(uint16_t type,
+                                    hsa_amd_agent_dispatch_handler handler,
+                                    void* data) {
+  if (!core::Runtime::IsOpen()) return HSA_STATUS_ERROR_NOT_INITIALIZED;
+
+  core::Runtime::runtime_singleton_->SetAgentDispatchHandler(type, handler,
+                                                             data);
+  return HSA_STATUS_SUCCESS;
+}
+
+//===----------------------------------------------------------------------===//
+// AMD Signal APIs.                                                           //
+//===----------------------------------------------------------------------===//
+
+hsa_status_t HSA_API
+    hsa_amd_signal_create_batch(uint32_t count,
+                                hsa_signal_value_t initial_value,
+                                uint32_t num_consumers,
+                                const hsa_agent_t* consumers,
+                                hsa_signal_t* hsa_signals) {
+  if (!core::Runtime::IsOpen()) return HSA_STATUS_ERROR_NOT_INITIALIZED;
+
+  if (count == 0) return HSA_STATUS_SUCCESS;
+
+  IS_BAD_PTR(hsa_signals);
+
+  if (num_consumers != 0) IS_BAD_PTR(consumers);
+
+  // Signals only consumed by devices never need a KFD event.
+  const bool host_waits = core::Signal::HostMayWait(num_consumers, consumers);
+  const bool use_interrupt = host_waits && core::g_use_interrupt_wait;
+  const bool use_hybrid = host_waits && core::g_use_hybrid_wait;
+
+  core::SignalPool& pool = core::Runtime::runtime_singleton_->signal_pool();
+  size_t size = sizeof(core::DefaultSignal);
+  if (use_interrupt)
+    size = sizeof(core::InterruptSignal);
+  else if (use_hybrid)
+    size = sizeof(core::HybridSignal);
+  std::vector<void*> blocks(count);
+  if (!pool.AllocBatch(size, count, &blocks[0]))
+    return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+
+  for (uint32_t i = 0; i < count; i++) {
+    core::Signal* signal;
+    if (use_interrupt) {
+      core::InterruptSignal* interrupt_signal =
+          new (blocks[i]) core::InterruptSignal(initial_value);
+      if (interrupt_signal->EopEvent() == NULL) {
+        // Out of KFD events, unwind the whole batch.
+        for (uint32_t j = 0; j <= i; j++)
+          reinterpret_cast<core::Signal*>(blocks[j])->~Signal();
+        pool.FreeBatch(&blocks[0], count);
+        return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+      }
+      signal = interrupt_signal;
+    } else if (use_hybrid) {
+      signal = new (blocks[i]) core::HybridSignal(initial_value);
+    } else {
+      signal = new (blocks[i]) core::DefaultSignal(initial_value);
+    }
+    hsa_signals[i] = core::Signal::Convert(signal);
+  }
+
+  return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t HSA_API
+    hsa_amd_signal_destroy_batch(uint32_t count,
+                                 const hsa_signal_t* hsa_signals) {
+  if (count == 0) return HSA_STATUS_SUCCESS;
+
+  IS_BAD_PTR(hsa_signals);
+
+  // Only signals from the signal pool can be returned in a batch.
+  std::vector<void*> blocks(count);
+  for (uint32_t i = 0; i < count; i++) {
+    core::Signal* signal = core::Signal::Convert(hsa_signals[i]);
+    IS_VALID(signal);
+    hsa_amd_ipc_signal_t handle;
+    if (!signal->IsMemorySignal() || signal->GetIpcHandle(&handle))
+      return HSA_STATUS_ERROR_INVALID_SIGNAL;
+    blocks[i] = signal;
+  }
+
+  // A signal listed twice would be destroyed and freed twice.
+  std::vector<void*> sorted(blocks);
+  std::sort(sorted.begin(), sorted.end());
+  if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+    return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+
+  // Signals with waiters are deleted by their last waiter instead.
+  uint32_t retired = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    core::Signal* signal = reinterpret_cast<core::Signal*>(blocks[i]);
+    if (!signal->Retire()) continue;
+    signal->~Signal();
+    blocks[retired++] = signal;
+  }
+  core::Runtime::runtime_singleton_->signal_pool().FreeBatch(&blocks[0],
+                                                             retired);
+
+  return HSA_STATUS_SUCCESS;
+}
+
+uint32_t HSA_API
+    hsa_amd_signal_wait_any(uint32_t signal_count, hsa_signal_t* hsa_signals,
+                            hsa_signal_condition_t* conds,
+                            hsa_signal_value_t* values, uint64_t timeout_hint,
+                            hsa_wait_expectancy_t wait_hint,
+                            hsa_signal_value_t* satisfying_value) {
+  assert(signal_count == 0 || (hsa_signals != NULL && conds != NULL &&
+                               values != NULL));
+#ifndef NDEBUG
+  for (uint32_t i = 0; i < signal_count; i++) {
+    const core::Signal* signal = core::Signal::Convert(hsa_signals[i]);
+    assert(signal != NULL && signal->IsValid());
+  }
+#endif
+
+  return core::Signal::WaitAny(signal_count, hsa_signals, conds, values,
+                               timeout_hint, wait_hint, satisfying_value);
+}
+
+uint32_t HSA_API
+    hsa_amd_signal_wait_all(uint32_t signal_count, hsa_signal_t* hsa_signals,
+                            hsa_signal_condition_t* conds,
+                            hsa_signal_value_t* values, uint64_t timeout_hint,
+                            hsa_wait_expectancy_t wait_hint,
+                            hsa_signal_value_t* satisfying_values) {
+  assert(signal_count == 0 || (hsa_signals != NULL && conds != NULL &&
+                               values != NULL));
+#ifndef NDEBUG
+  for (uint32_t i = 0; i < signal_count; i++) {
+    const core::Signal* signal = core::Signal::Convert(hsa_signals[i]);
+    assert(signal != NULL && signal->IsValid());
+  }
+#endif
+
+  return core::Signal::WaitAll(signal_count, hsa_signals, conds, values,
+                               timeout_hint, wait_hint, satisfying_values);
+}
+
+hsa_status_t HSA_API
+    hsa_amd_signal_async_handler(hsa_signal_t hsa_signal,
+                                 hsa_signal_condition_t cond,
+                                 hsa_signal_value_t value,
+                                 hsa_amd_signal_handler handler, void* arg) {
+  if (!core::Runtime::IsOpen()) return HSA_STATUS_ERROR_NOT_INITIALIZED;
+
+  core::Signal* signal = core::Signal::Convert(hsa_signal);
+
+  IS_VALID(signal);
+
+  IS_BAD_PTR(handler);
+
+  if (!core::Signal::IsValidCondition(cond))
+    return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+
+  return core::Runtime::runtime_singleton_->SetAsyncSignalHandler(
+      hsa_signal, cond, value, handler, arg);
+}
+
+hsa_status_t HSA_API
+    hsa_amd_signal_async_handler_cancelable(
+        hsa_signal_t hsa_signal, hsa_signal_condition_t cond,
+        hsa_signal_value_t value, hsa_amd_signal_handler handler,
+        hsa_amd_signal_cancel_handler cancel, void* arg) {
+  if (!core::Runtime::IsOpen()) return HSA_STATUS_ERROR_NOT_INITIALIZED;
+
+  core::Signal* signal = core::Signal::Convert(hsa_signal);
+
+  IS_VALID(signal);
+
+  IS_BAD_PTR(handler);
+
+  IS_BAD_PTR(cancel);
+
+  if (!core::Signal::IsValidCondition(cond))
+    return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+
+  return core::Runtime::runtime_singleton_->SetAsyncSignalHandler(
+      hsa_signal, cond, value, handler, arg, cancel);
+}
+
+// Async signal handler making the eventfd passed as arg readable, once. arg
+// is the runtime's own duplicate of the descriptor, closed once done with.
+static bool EventFdHandler(hsa_signal_value_t value, void* arg) {
+  int fd = int(reinterpret_cast<intptr_t>(arg));
+  os::SetPollableEvent(fd);
+  os::DestroyPollableEvent(fd);
+  return false;
+}
+
+// Closes the duplicate when the signal is destroyed before the condition held.
+static void EventFdCancel(void* arg) {
+  os::DestroyPollableEvent(int(reinterpret_cast<intptr_t>(arg)));
+}
+
+hsa_status_t HSA_API
+    hsa_amd_signal_attach_eventfd(hsa_signal_t hsa_signal,
+                                  hsa_signal_condition_t cond,
+                                  hsa_signal_value_t value, int fd) {
+  if (!core::Runtime::IsOpen()) return HSA_STATUS_ERROR_NOT_INITIALIZED;
+
+  core::Signal* signal = core::Signal::Convert(hsa_signal);
+
+  IS_VALID(signal);
+
+  if (fd < 0 || !core::Signal::IsValidCondition(cond))
+    return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+
+  // Write to a private duplicate so that the application closing fd, and the
+  // number being reused, cannot redirect the notification.
+  int dup_fd = os::DuplicatePollableEvent(fd);
+  if (dup_fd < 0) return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+
+  hsa_status_t err = core::Runtime::runtime_singleton_->SetAsyncSignalHandler(
+      hsa_signal, cond, value, EventFdHandler,
+      reinterpret_cast<void*>(intptr_t(dup_fd)), EventFdCancel);
+  if (err != HSA_STATUS_SUCCESS) os::DestroyPollableEvent(dup_fd);
+  return err;
+}
+
+hsa_status_t HSA_API
+    hsa_amd_signal_get_eventfd(hsa_signal_t hsa_signal,
+                               hsa_signal_condition_t cond,
+                               hsa_signal_value_t value, int* fd) {
+  IS_BAD_PTR(fd);
+
+  int event_fd = os::CreatePollableEvent();
+  if (event_fd < 0) return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+
+  hsa_status_t err =
+      hsa_amd_signal_attach_eventfd(hsa_signal, cond, value, event_fd);
+  if (err != HSA_STATUS_SUCCESS) {
+    os::DestroyPollableEvent(event_fd);
+    return err;
+  }
+
+  *fd = event_fd;
+  return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t HSA_API
+    hsa_amd_signal_ipc_create(hsa_signal_value_t initial_value,
+                              hsa_signal_t* hsa_signal) {
+  if (!core::Runtime::IsOpen()) return HSA_STATUS_ERROR_NOT_INITIALIZED;
+
+  IS_BAD_PTR(hsa_signal);
+
+  core::Signal* signal = core::IpcSignal::Create(initial_value);
+  if (signal == NULL) return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+
+  *hsa_signal = core::Signal::Convert(signal);
+  return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t HSA_API
+    hsa_amd_signal_ipc_handle_get(hsa_signal_t hsa_signal,
+                                  hsa_amd_ipc_signal_t* handle) {
+  const core::Signal* signal = core::Signal::Convert(hsa_signal);
+
+  IS_VALID(signal);
+
+  IS_BAD_PTR(handle);
+
+  if (!signal->GetIpcHandle(handle)) return HSA_STATUS_ERROR_INVALID_SIGNAL;
+
+  return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t HSA_API
+    hsa_amd_signal_ipc_attach(const hsa_amd_ipc_signal_t* handle,
+                              hsa_signal_t* hsa_signal) {
+  if (!core::Runtime::IsOpen()) return HSA_STATUS_ERROR_NOT_INITIALIZED;
+
+  IS_BAD_PTR(handle);
+
+  IS_BAD_PTR(hsa_signal);
+
+  core::Signal* signal = core::IpcSignal::Attach(*handle);
+  if (signal == NULL) return HSA_STATUS_ERROR_INVALID_ARGUMENT;
+
+  *hsa_signal = core::Signal::Convert(signal);
+  return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t HSA_API hsa_amd_signal_get_stats(hsa_signal_t hsa_signal,
+                                              hsa_amd_signal_stats_t* stats) {
+#ifdef HSA_NO_SIGNAL_STATS
+  return HSA_STATUS_ERROR;
+#else
+  const core::Signal* signal = core::Signal::Convert(hsa_signal);
+
+  IS_VALID(signal);
+
+  IS_BAD_PTR(stats);
+
+  signal->GetStats(stats);
+
+  return HSA_STATUS_SUCCESS;
+#endif
+}
+
+hsa_status_t HSA_API
+    hsa_amd_signal_get_wait_histogram(uint64_t* buckets,
+                                      uint32_t bucket_count) {
+#ifdef HSA_NO_SIGNAL_STATS
+  return HSA_STATUS_ERROR;
+#else
+  if (bucket_count != 0) IS_BAD_PTR(buckets);
+
+  core::Signal::GetWaitHistogram(buckets, bucket_count);
+
+  return HSA_STATUS_SUCCESS;
+#endif
+}
+
 //===----------------------------------------------------------------------===//
 // HSA Code Unit APIs.                                                        //
 //===----------------------------------------------------------------------===//
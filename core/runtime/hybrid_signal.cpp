@@ -0,0 +1,235 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "core/inc/hybrid_signal.h"
+
+namespace core {
+
+static_assert(sizeof(HybridSignal) <= SignalPool::kBlockSize,
+              "HybridSignal does not fit in a signal pool block.");
+
+HybridSignal::HybridSignal(hsa_signal_value_t initial_value)
+    : DefaultSignal(initial_value), event_users_(0), event_(NULL) {}
+
+HybridSignal::~HybridSignal() {
+  // The last waiter detached the event before leaving.
+  assert(event_ == NULL && "Event still attached.");
+}
+
+void HybridSignal::Notify() {
+  DefaultSignal::Notify();
+
+  // Hold a reference on the event so it stays attached while it is set
+  // without the lock.
+  HsaEvent* event;
+  {
+    ScopedAcquire<SpinMutex> lock(&event_lock_);
+    if (event_ == NULL) return;
+    event_users_++;
+    event = event_;
+  }
+  hsaKmtSetEvent(event);
+  DetachEvent();
+}
+
+bool HybridSignal::AttachEvent() {
+  {
+    ScopedAcquire<SpinMutex> lock(&event_lock_);
+    if (event_ != NULL) {
+      event_users_++;
+      return true;
+    }
+  }
+
+  // Allocated without the lock since creating an event is a syscall.
+  HsaEvent* event = Runtime::runtime_singleton_->event_pool().Alloc();
+  if (event == NULL) return false;
+  {
+    ScopedAcquire<SpinMutex> lock(&event_lock_);
+    if (event_ == NULL) {
+      event_ = event;
+      event = NULL;
+      signal_.event_id = event_->EventId;
+      atomic::Store(&signal_.event_mailbox_ptr, event_->EventData.HWData2,
+                    std::memory_order_release);
+      // Order the mailbox before the waiter's next sample of the value.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    event_users_++;
+  }
+
+  // Another thread attached an event first.
+  if (event != NULL) Runtime::runtime_singleton_->event_pool().Free(event);
+  return true;
+}
+
+HsaEvent* HybridSignal::AcquireEvent() {
+  if (!AttachEvent()) return NULL;
+  // Stays attached, and so unchanged, until the matching ReleaseEvent.
+  return event_;
+}
+
+void HybridSignal::DetachEvent() {
+  HsaEvent* event;
+  {
+    ScopedAcquire<SpinMutex> lock(&event_lock_);
+    assert(event_users_ != 0 && "Unbalanced event detach.");
+    if (--event_users_ != 0) return;
+    atomic::Store(&signal_.event_mailbox_ptr, uint64_t(0),
+                  std::memory_order_release);
+    signal_.event_id = 0;
+    event = event_;
+    event_ = NULL;
+  }
+  // Freed without the lock since destroying an event is a syscall.
+  Runtime::runtime_singleton_->event_pool().Free(event);
+}
+
+hsa_signal_value_t HybridSignal::WaitRelaxed(hsa_signal_condition_t condition,
+                                             hsa_signal_value_t compare_value,
+                                             uint64_t timeout,
+                                             hsa_wait_expectancy_t wait_hint) {
+  if (!IsValidCondition(condition)) return 0;
+
+  // Publish the waiter before sampling the value, pairs with NotifyIfWaiting.
+  AddWaiter();
+  bool attached = false;
+  MAKE_SCOPE_GUARD([&]() {
+    if (attached) DetachEvent();
+    RemoveWaiter();
+  });
+  WaitRecord record(this);
+  WaitPolicy policy(wait_hint, &wait_history_);
+  SpinWait spin;
+
+  const bool infinite = (timeout == uint64_t(-1));
+  const SystemClock& clock = Runtime::runtime_singleton_->system_clock();
+  uint64_t start_time = 0, sys_time;
+  if (!infinite) start_time = clock.Timestamp();
+
+  // Bounds the first block after attaching, for device writes which missed
+  // the mailbox, and blocks while other threads wait, in case a wakeup was
+  // consumed before this thread blocked.
+  const uint32_t kBoundedWaitMs = 1;
+  bool first_block = true;
+
+  // Without an event waiters park on the low word of the value like
+  // DefaultSignal.
+  const uint64_t kParkNs = 1000000;
+
+  int64_t value;
+  while (true) {
+    if (invalid_) return 0;
+
+    value = atomic::Load(&signal_.value, std::memory_order_relaxed);
+
+    if (CheckCondition(condition, hsa_signal_value_t(value), compare_value)) {
+      policy.Satisfied();
+      return hsa_signal_value_t(value);
+    }
+
+    WaitPolicy::Phase phase = policy.Next();
+    if (phase == WaitPolicy::kSpin) {
+      record.Spin();
+      spin.Wait(&signal_.value, value);
+      continue;
+    }
+
+    uint64_t remaining_ns = uint64_t(-1);
+    if (!infinite) {
+      sys_time = clock.Timestamp();
+      if (sys_time - start_time > timeout) {
+        record.Timeout();
+        value = atomic::Load(&signal_.value, std::memory_order_relaxed);
+        return hsa_signal_value_t(value);
+      }
+      remaining_ns = clock.TicksToNs(timeout - (sys_time - start_time));
+    }
+
+    if (phase == WaitPolicy::kYield) {
+      os::YieldThread();
+      continue;
+    }
+
+    // Attach, then sample the value again before blocking.
+    if (!attached) {
+      attached = AttachEvent();
+      if (attached) continue;
+    }
+
+    record.BlockBegin();
+    bool notified;
+    if (attached) {
+      // Rounded up, a zero timeout would spin on the syscall until the
+      // deadline.
+      uint32_t wait_ms = uint32_t(-1);
+      if (!infinite)
+        wait_ms = uint32_t(
+            Min((remaining_ns + 999999) / 1000000, uint64_t(UINT32_MAX - 1)));
+      if (first_block || Waiters() > 1) wait_ms = Min(wait_ms, kBoundedWaitMs);
+      first_block = false;
+      HSAKMT_STATUS err = hsaKmtWaitOnEvent(event_, wait_ms);
+      notified = (err != HSAKMT_STATUS_WAIT_TIMEOUT);
+    } else {
+      uint64_t park_ns = Max(Min(kParkNs, remaining_ns), uint64_t(1));
+      notified = os::WaitOnAddress((volatile uint32_t*)&signal_.value,
+                                   uint32_t(value), park_ns);
+    }
+    record.BlockEnd(notified);
+  }
+}
+
+hsa_signal_value_t HybridSignal::WaitAcquire(hsa_signal_condition_t condition,
+                                             hsa_signal_value_t compare_value,
+                                             uint64_t timeout,
+                                             hsa_wait_expectancy_t wait_hint) {
+  hsa_signal_value_t ret =
+      WaitRelaxed(condition, compare_value, timeout, wait_hint);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return ret;
+}
+
+}  // namespace core
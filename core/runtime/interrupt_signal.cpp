@@ -47,36 +47,22 @@
 #include "core/inc/interrupt_signal.h"
 
 namespace core {
+
+static_assert(sizeof(InterruptSignal) <= SignalPool::kBlockSize,
+              "InterruptSignal does not fit in a signal pool block.");
+
 InterruptSignal::InterruptSignal(hsa_signal_value_t initial_value)
-    : Signal(initial_value), invalid_(false), waiting_(0) {
-  HsaEventDescriptor event_descriptor;
-#ifdef __linux__
-  event_descriptor.EventType = HSA_EVENTTYPE_SIGNAL;
-#else
-  event_descriptor.EventType = HSA_EVENTTYPE_QUEUE_EVENT;
-#endif
-  event_descriptor.SyncVar.SyncVar.UserData = (void*)&signal_.value;
-  event_descriptor.SyncVar.SyncVarSize = sizeof(hsa_signal_value_t);
-  event_descriptor.NodeId = 0;
-  if (hsaKmtCreateEvent(&event_descriptor, false, false, &event_) !=
-      HSAKMT_STATUS_SUCCESS) {
-    event_ = NULL;
-    return;
-  }
+    : Signal(initial_value) {
+  event_ = Runtime::runtime_singleton_->event_pool().Alloc();
+  if (event_ == NULL) return;
   signal_.type = kHsaSignalAmd;
   signal_.event_id = event_->EventId;
   signal_.event_mailbox_ptr = event_->EventData.HWData2;
-
-  hsa_memory_register(this, sizeof(InterruptSignal));
 }
 
 InterruptSignal::~InterruptSignal() {
   invalid_ = true;
-  hsaKmtSetEvent(event_);
-  while (waiting_ != 0)
-    ;
-  hsaKmtDestroyEvent(event_);
-  hsa_memory_deregister(this, sizeof(InterruptSignal));
+  Runtime::runtime_singleton_->event_pool().Free(event_);
 }
 
 InterruptSignal* InterruptSignal::Create(hsa_signal_value_t initial_value,
@@ -91,89 +77,93 @@ InterruptSignal* InterruptSignal::Create(hsa_signal_value_t initial_value,
 }
 
 hsa_signal_value_t InterruptSignal::LoadRelaxed() {
-  return hsa_signal_value_t(
-      atomic::Load(&signal_.value, std::memory_order_relaxed));
+  return Load<std::memory_order_relaxed>();
 }
 
 hsa_signal_value_t InterruptSignal::LoadAcquire() {
-  return hsa_signal_value_t(
-      atomic::Load(&signal_.value, std::memory_order_acquire));
+  return Load<std::memory_order_acquire>();
 }
 
 void InterruptSignal::StoreRelaxed(hsa_signal_value_t value) {
-  atomic::Store(&signal_.value, int64_t(value), std::memory_order_relaxed);
-  hsaKmtSetEvent(event_);
+  Store<std::memory_order_relaxed>(value);
 }
 
 void InterruptSignal::StoreRelease(hsa_signal_value_t value) {
-  atomic::Store(&signal_.value, int64_t(value), std::memory_order_release);
-  hsaKmtSetEvent(event_);
+  Store<std::memory_order_release>(value);
 }
 
 hsa_signal_value_t InterruptSignal::WaitRelaxed(
     hsa_signal_condition_t condition, hsa_signal_value_t compare_value,
     uint64_t timeout, hsa_wait_expectancy_t wait_hint) {
-  uint32_t prior = atomic::Increment(&waiting_);
-  assert(prior == 0 && "Multiple waiters on interrupt signal!");
-  MAKE_SCOPE_GUARD([&]() { atomic::Decrement(&waiting_); });
+  if (!IsValidCondition(condition)) return 0;
+
+  // Publish the waiter before sampling the value, pairs with NotifyIfWaiting.
+  AddWaiter();
+  MAKE_SCOPE_GUARD([&]() {
+    // Pass the wakeup on to waiters which were not yet blocked when the event
+    // was set. Done before leaving since the last waiter of a retired signal
+    // releases the event.
+    if (Waiters() != 1) hsaKmtSetEvent(event_);
+    RemoveWaiter();
+  });
+  WaitRecord record(this);
+  WaitPolicy policy(wait_hint, &wait_history_);
+  SpinWait spin;
 
   int64_t value;
 
-  uint64_t fast_start_time = __rdtsc();
-  //~200us at 4GHz - does not need to be an exact time, just a short while
-  const uint64_t kMaxElapsed = 800000;
+  // Bounds a blocking wait while other threads wait too, in case a wakeup
+  // was consumed before this thread blocked.
+  const uint32_t kMultiWaiterWaitMs = 1;
 
-  uint64_t hsa_freq;
-  hsa_system_get_info(HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY, &hsa_freq);
-  const float invFreq = 1000.0f / hsa_freq;  // clock period in ms
+  const SystemClock& clock = Runtime::runtime_singleton_->system_clock();
+  const double invFreq = 1000.0 / double(clock.Frequency());  // period in ms
 
   uint64_t start_time, sys_time;
-  hsa_system_get_info(HSA_SYSTEM_INFO_TIMESTAMP, &start_time);
+  start_time = clock.Timestamp();
 
-  bool condition_met = false;
   while (true) {
     if (invalid_) return 0;
 
     value = atomic::Load(&signal_.value, std::memory_order_relaxed);
 
-    switch (condition) {
-      case HSA_EQ: {
-        condition_met = (value == compare_value);
-        break;
-      }
-      case HSA_NE: {
-        condition_met = (value != compare_value);
-        break;
-      }
-      case HSA_GTE: {
-        condition_met = (value >= compare_value);
-        break;
-      }
-      case HSA_LT: {
-        condition_met = (value < compare_value);
-        break;
-      }
-      default:
-        return 0;
+    if (CheckCondition(condition, hsa_signal_value_t(value), compare_value)) {
+      policy.Satisfied();
+      return hsa_signal_value_t(value);
+    }
+
+    WaitPolicy::Phase phase = policy.Next();
+    if (phase == WaitPolicy::kSpin) {
+      record.Spin();
+      spin.Wait(&signal_.value, value);
+      continue;
     }
-    if (condition_met) return hsa_signal_value_t(value);
-
-    uint64_t time = __rdtsc();
-    if (time - fast_start_time > kMaxElapsed) {
-      hsa_system_get_info(HSA_SYSTEM_INFO_TIMESTAMP, &sys_time);
-      if (sys_time - start_time > timeout) {
-        value = atomic::Load(&signal_.value, std::memory_order_relaxed);
-        return hsa_signal_value_t(value);
-      }
-      if (wait_hint != HSA_WAIT_EXPECTANCY_SHORT) {
-        uint32_t wait_ms;
-        if (timeout == -1)
-          wait_ms = uint32_t(-1);
-        else
-          wait_ms = uint32_t((timeout - (sys_time - start_time)) * invFreq);
-        hsaKmtWaitOnEvent(event_, wait_ms);
-      }
+
+    sys_time = clock.Timestamp();
+    if (sys_time - start_time > timeout) {
+      record.Timeout();
+      value = atomic::Load(&signal_.value, std::memory_order_relaxed);
+      return hsa_signal_value_t(value);
     }
+
+    if (phase == WaitPolicy::kYield) {
+      os::YieldThread();
+      continue;
+    }
+
+    // Rounded up, a zero timeout would spin on the syscall until the
+    // deadline.
+    uint32_t wait_ms;
+    if (timeout == -1)
+      wait_ms = uint32_t(-1);
+    else
+      wait_ms = uint32_t(
+          Min(uint64_t((timeout - (sys_time - start_time)) * invFreq) + 1,
+              uint64_t(UINT32_MAX - 1)));
+    if (Waiters() > 1) wait_ms = Min(wait_ms, kMultiWaiterWaitMs);
+    record.BlockBegin();
+    HSAKMT_STATUS err = hsaKmtWaitOnEvent(event_, wait_ms);
+    record.BlockEnd(err != HSAKMT_STATUS_WAIT_TIMEOUT);
   }
 }
 
@@ -187,159 +177,119 @@ hsa_signal_value_t InterruptSignal::WaitAcquire(
 }
 
 void InterruptSignal::AndRelaxed(hsa_signal_value_t value) {
-  atomic::And(&signal_.value, int64_t(value), std::memory_order_relaxed);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpAnd, std::memory_order_relaxed>(value);
 }
 
 void InterruptSignal::AndAcquire(hsa_signal_value_t value) {
-  atomic::And(&signal_.value, int64_t(value), std::memory_order_acquire);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpAnd, std::memory_order_acquire>(value);
 }
 
 void InterruptSignal::AndRelease(hsa_signal_value_t value) {
-  atomic::And(&signal_.value, int64_t(value), std::memory_order_release);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpAnd, std::memory_order_release>(value);
 }
 
 void InterruptSignal::AndAcqRel(hsa_signal_value_t value) {
-  atomic::And(&signal_.value, int64_t(value), std::memory_order_acq_rel);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpAnd, std::memory_order_acq_rel>(value);
 }
 
 void InterruptSignal::OrRelaxed(hsa_signal_value_t value) {
-  atomic::Or(&signal_.value, int64_t(value), std::memory_order_relaxed);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpOr, std::memory_order_relaxed>(value);
 }
 
 void InterruptSignal::OrAcquire(hsa_signal_value_t value) {
-  atomic::Or(&signal_.value, int64_t(value), std::memory_order_acquire);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpOr, std::memory_order_acquire>(value);
 }
 
 void InterruptSignal::OrRelease(hsa_signal_value_t value) {
-  atomic::Or(&signal_.value, int64_t(value), std::memory_order_release);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpOr, std::memory_order_release>(value);
 }
 
 void InterruptSignal::OrAcqRel(hsa_signal_value_t value) {
-  atomic::Or(&signal_.value, int64_t(value), std::memory_order_acq_rel);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpOr, std::memory_order_acq_rel>(value);
 }
 
 void InterruptSignal::XorRelaxed(hsa_signal_value_t value) {
-  atomic::Xor(&signal_.value, int64_t(value), std::memory_order_relaxed);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpXor, std::memory_order_relaxed>(value);
 }
 
 void InterruptSignal::XorAcquire(hsa_signal_value_t value) {
-  atomic::Xor(&signal_.value, int64_t(value), std::memory_order_acquire);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpXor, std::memory_order_acquire>(value);
 }
 
 void InterruptSignal::XorRelease(hsa_signal_value_t value) {
-  atomic::Xor(&signal_.value, int64_t(value), std::memory_order_release);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpXor, std::memory_order_release>(value);
 }
 
 void InterruptSignal::XorAcqRel(hsa_signal_value_t value) {
-  atomic::Xor(&signal_.value, int64_t(value), std::memory_order_acq_rel);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpXor, std::memory_order_acq_rel>(value);
 }
 
 void InterruptSignal::AddRelaxed(hsa_signal_value_t value) {
-  atomic::Add(&signal_.value, int64_t(value), std::memory_order_relaxed);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpAdd, std::memory_order_relaxed>(value);
 }
 
 void InterruptSignal::AddAcquire(hsa_signal_value_t value) {
-  atomic::Add(&signal_.value, int64_t(value), std::memory_order_acquire);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpAdd, std::memory_order_acquire>(value);
 }
 
 void InterruptSignal::AddRelease(hsa_signal_value_t value) {
-  atomic::Add(&signal_.value, int64_t(value), std::memory_order_release);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpAdd, std::memory_order_release>(value);
 }
 
 void InterruptSignal::AddAcqRel(hsa_signal_value_t value) {
-  atomic::Add(&signal_.value, int64_t(value), std::memory_order_acq_rel);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpAdd, std::memory_order_acq_rel>(value);
 }
 
 void InterruptSignal::SubRelaxed(hsa_signal_value_t value) {
-  atomic::Sub(&signal_.value, int64_t(value), std::memory_order_relaxed);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpSub, std::memory_order_relaxed>(value);
 }
 
 void InterruptSignal::SubAcquire(hsa_signal_value_t value) {
-  atomic::Sub(&signal_.value, int64_t(value), std::memory_order_acquire);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpSub, std::memory_order_acquire>(value);
 }
 
 void InterruptSignal::SubRelease(hsa_signal_value_t value) {
-  atomic::Sub(&signal_.value, int64_t(value), std::memory_order_release);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpSub, std::memory_order_release>(value);
 }
 
 void InterruptSignal::SubAcqRel(hsa_signal_value_t value) {
-  atomic::Sub(&signal_.value, int64_t(value), std::memory_order_acq_rel);
-  hsaKmtSetEvent(event_);
+  Modify<kSignalOpSub, std::memory_order_acq_rel>(value);
 }
 
 hsa_signal_value_t InterruptSignal::ExchRelaxed(hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Exchange(&signal_.value, int64_t(value),
-                                             std::memory_order_relaxed));
-  hsaKmtSetEvent(event_);
+  return Exchange<std::memory_order_relaxed>(value);
 }
 
 hsa_signal_value_t InterruptSignal::ExchAcquire(hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Exchange(&signal_.value, int64_t(value),
-                                             std::memory_order_acquire));
-  hsaKmtSetEvent(event_);
+  return Exchange<std::memory_order_acquire>(value);
 }
 
 hsa_signal_value_t InterruptSignal::ExchRelease(hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Exchange(&signal_.value, int64_t(value),
-                                             std::memory_order_release));
-  hsaKmtSetEvent(event_);
+  return Exchange<std::memory_order_release>(value);
 }
 
 hsa_signal_value_t InterruptSignal::ExchAcqRel(hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Exchange(&signal_.value, int64_t(value),
-                                             std::memory_order_acq_rel));
-  hsaKmtSetEvent(event_);
+  return Exchange<std::memory_order_acq_rel>(value);
 }
 
 hsa_signal_value_t InterruptSignal::CasRelaxed(hsa_signal_value_t expected,
                                                hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Cas(&signal_.value, int64_t(value),
-                                        int64_t(expected),
-                                        std::memory_order_relaxed));
-  hsaKmtSetEvent(event_);
+  return CompareExchange<std::memory_order_relaxed>(expected, value);
 }
 
 hsa_signal_value_t InterruptSignal::CasAcquire(hsa_signal_value_t expected,
                                                hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Cas(&signal_.value, int64_t(value),
-                                        int64_t(expected),
-                                        std::memory_order_acquire));
-  hsaKmtSetEvent(event_);
+  return CompareExchange<std::memory_order_acquire>(expected, value);
 }
 
 hsa_signal_value_t InterruptSignal::CasRelease(hsa_signal_value_t expected,
                                                hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Cas(&signal_.value, int64_t(value),
-                                        int64_t(expected),
-                                        std::memory_order_release));
-  hsaKmtSetEvent(event_);
+  return CompareExchange<std::memory_order_release>(expected, value);
 }
 
 hsa_signal_value_t InterruptSignal::CasAcqRel(hsa_signal_value_t expected,
                                               hsa_signal_value_t value) {
-  return hsa_signal_value_t(atomic::Cas(&signal_.value, int64_t(value),
-                                        int64_t(expected),
-                                        std::memory_order_acq_rel));
-  hsaKmtSetEvent(event_);
+  return CompareExchange<std::memory_order_acq_rel>(expected, value);
 }
 
 }  // namespace core
@@ -0,0 +1,419 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+#include "core/inc/ipc_signal.h"
+
+namespace core {
+
+static_assert(IpcSignal::kHeaderOffset >= sizeof(int64_t) &&
+                  IpcSignal::kHeaderOffset + sizeof(IpcSignalHeader) <=
+                      IpcSignal::kPageSize,
+              "IpcSignalHeader does not fit in the shared page.");
+
+// Distinguishes signals created by this process.
+static volatile uint64_t ipc_signal_count = 0;
+
+IpcSignal* IpcSignal::Create(hsa_signal_value_t initial_value) {
+  int fd = os::CreateSharedMemory(kPageSize);
+  if (fd == -1) return NULL;
+
+  void* page = os::MapSharedMemory(fd, kPageSize);
+  if (page == NULL) {
+    os::CloseSharedMemory(fd);
+    return NULL;
+  }
+
+  // Ids combine the creation time with a per process count so that they do
+  // not repeat across signals or across processes reusing a pid.
+  uint64_t id =
+      (Runtime::runtime_singleton_->system_clock().Timestamp() << 16) ^
+      atomic::Increment(&ipc_signal_count);
+
+  uint8_t* base = reinterpret_cast<uint8_t*>(page);
+  *reinterpret_cast<volatile int64_t*>(base) = int64_t(initial_value);
+  IpcSignalHeader* header =
+      reinterpret_cast<IpcSignalHeader*>(base + kHeaderOffset);
+  header->id = id;
+  header->value_offset = 0;
+  header->retired = 0;
+  header->waiters = 0;
+  atomic::Store(&header->magic, IpcSignalHeader::kMagic,
+                std::memory_order_release);
+
+  return new IpcSignal(fd, page, id, true);
+}
+
+IpcSignal* IpcSignal::Attach(const hsa_amd_ipc_signal_t& handle) {
+  // A descriptor of this process, for example received over a Unix socket,
+  // is used directly. Otherwise open the creator's through procfs.
+  int fd = (handle.pid == os::GetProcessId())
+               ? os::DuplicateSharedMemory(handle.fd)
+               : os::OpenSharedMemory(handle.pid, handle.fd);
+  if (fd == -1) return NULL;
+
+  void* page = os::MapSharedMemory(fd, kPageSize);
+  if (page == NULL) {
+    os::CloseSharedMemory(fd);
+    return NULL;
+  }
+
+  // The descriptor may have been reused for an unrelated object or another
+  // signal.
+  const IpcSignalHeader* header = reinterpret_cast<IpcSignalHeader*>(
+      reinterpret_cast<uint8_t*>(page) + kHeaderOffset);
+  if (atomic::Load(&header->magic, std::memory_order_acquire) !=
+          IpcSignalHeader::kMagic ||
+      header->id != handle.id ||
+      header->value_offset + sizeof(int64_t) > kHeaderOffset ||
+      (header->value_offset & (sizeof(int64_t) - 1)) != 0) {
+    os::UnmapSharedMemory(page, kPageSize);
+    os::CloseSharedMemory(fd);
+    return NULL;
+  }
+
+  return new IpcSignal(fd, page, handle.id, false);
+}
+
+IpcSignal::IpcSignal(int fd, void* page, uint64_t id, bool creator)
+    : Signal(0), fd_(fd), page_(page), id_(id), creator_(creator) {
+  uint8_t* base = reinterpret_cast<uint8_t*>(page);
+  header_ = reinterpret_cast<IpcSignalHeader*>(base + kHeaderOffset);
+  // Read the offset once, later writes to the page cannot move the value.
+  value_ = reinterpret_cast<volatile int64_t*>(
+      base + atomic::Load(&header_->value_offset));
+  signal_.type = kHsaSignalAmdIpc;
+  signal_.event_mailbox_ptr = NULL;
+}
+
+IpcSignal::~IpcSignal() {
+  invalid_ = true;
+  os::UnmapSharedMemory(page_, kPageSize);
+  os::CloseSharedMemory(fd_);
+}
+
+bool IpcSignal::Retire() {
+  if (creator_) {
+    // Waiters of other processes observe the flag once woken.
+    atomic::Store(&header_->retired, 1U, std::memory_order_release);
+    NotifyShared();
+  }
+  return Signal::Retire();
+}
+
+bool IpcSignal::GetIpcHandle(hsa_amd_ipc_signal_t* handle) const {
+  handle->pid = os::GetProcessId();
+  handle->fd = fd_;
+  handle->id = id_;
+  return true;
+}
+
+void IpcSignal::Notify() {
+  if (atomic::Load(&header_->waiters, std::memory_order_relaxed) != 0)
+    os::WakeByAddress((volatile uint32_t*)value_, UINT32_MAX, true);
+  WakeMultiWaiters();
+}
+
+template <SignalOp op, std::memory_order order>
+void IpcSignal::ModifyShared(hsa_signal_value_t value) {
+  switch (op) {
+    case kSignalOpAnd:
+      atomic::And(value_, int64_t(value), order);
+      break;
+    case kSignalOpOr:
+      atomic::Or(value_, int64_t(value), order);
+      break;
+    case kSignalOpXor:
+      atomic::Xor(value_, int64_t(value), order);
+      break;
+    case kSignalOpAdd:
+      atomic::Add(value_, int64_t(value), order);
+      break;
+    case kSignalOpSub:
+      atomic::Sub(value_, int64_t(value), order);
+      break;
+  }
+  NotifyShared();
+}
+
+hsa_signal_value_t IpcSignal::LoadRelaxed() {
+  return hsa_signal_value_t(atomic::Load(value_, std::memory_order_relaxed));
+}
+
+hsa_signal_value_t IpcSignal::LoadAcquire() {
+  return hsa_signal_value_t(atomic::Load(value_, std::memory_order_acquire));
+}
+
+void IpcSignal::StoreRelaxed(hsa_signal_value_t value) {
+  atomic::Store(value_, int64_t(value), std::memory_order_relaxed);
+  NotifyShared();
+}
+
+void IpcSignal::StoreRelease(hsa_signal_value_t value) {
+  atomic::Store(value_, int64_t(value), std::memory_order_release);
+  NotifyShared();
+}
+
+hsa_signal_value_t IpcSignal::WaitRelaxed(
+    hsa_signal_condition_t condition, hsa_signal_value_t compare_value,
+    uint64_t timeout, hsa_wait_expectancy_t wait_hint) {
+  if (!IsValidCondition(condition)) return 0;
+
+  // Publish the waiter locally, for Retire, and in the page, for updaters of
+  // every process, before sampling the value.
+  AddWaiter();
+  atomic::Increment(&header_->waiters, std::memory_order_seq_cst);
+  MAKE_SCOPE_GUARD([&]() {
+    atomic::Decrement(&header_->waiters);
+    RemoveWaiter();
+  });
+  WaitRecord record(this);
+  WaitPolicy policy(wait_hint, &wait_history_);
+  SpinWait spin;
+
+  volatile uint32_t* value_word = (volatile uint32_t*)value_;
+
+  const bool infinite = (timeout == uint64_t(-1));
+  const SystemClock& clock = Runtime::runtime_singleton_->system_clock();
+  uint64_t start_time = 0, sys_time;
+  if (!infinite) start_time = clock.Timestamp();
+
+  // Device writes in the exporting process do not wake the futex, so parks
+  // are bounded as in DefaultSignal.
+  const uint64_t kMinParkNs = 20000;
+  const uint64_t kMaxParkNs = 1000000;
+  uint64_t park_ns = kMinParkNs;
+
+  int64_t value;
+  while (true) {
+    if (IsRetired()) return 0;
+
+    value = atomic::Load(value_, std::memory_order_relaxed);
+    if (CheckCondition(condition, hsa_signal_value_t(value), compare_value)) {
+      policy.Satisfied();
+      return hsa_signal_value_t(value);
+    }
+
+    WaitPolicy::Phase phase = policy.Next();
+    if (phase == WaitPolicy::kSpin) {
+      record.Spin();
+      spin.Wait(value_, value);
+      continue;
+    }
+
+    uint64_t remaining_ns = kMaxParkNs;
+    if (!infinite) {
+      sys_time = clock.Timestamp();
+      if (sys_time - start_time > timeout) {
+        record.Timeout();
+        value = atomic::Load(value_, std::memory_order_relaxed);
+        return hsa_signal_value_t(value);
+      }
+      remaining_ns = clock.TicksToNs(timeout - (sys_time - start_time));
+    }
+
+    if (phase == WaitPolicy::kYield) {
+      os::YieldThread();
+      continue;
+    }
+
+    record.BlockBegin();
+    bool notified = os::WaitOnAddress(
+        value_word, uint32_t(value),
+        Max(Min(park_ns, remaining_ns), uint64_t(1)), true);
+    record.BlockEnd(notified);
+    park_ns = Min(park_ns * 2, kMaxParkNs);
+  }
+}
+
+hsa_signal_value_t IpcSignal::WaitAcquire(
+    hsa_signal_condition_t condition, hsa_signal_value_t compare_value,
+    uint64_t timeout, hsa_wait_expectancy_t wait_hint) {
+  hsa_signal_value_t ret =
+      WaitRelaxed(condition, compare_value, timeout, wait_hint);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return ret;
+}
+
+void IpcSignal::AndRelaxed(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpAnd, std::memory_order_relaxed>(value);
+}
+
+void IpcSignal::AndAcquire(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpAnd, std::memory_order_acquire>(value);
+}
+
+void IpcSignal::AndRelease(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpAnd, std::memory_order_release>(value);
+}
+
+void IpcSignal::AndAcqRel(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpAnd, std::memory_order_acq_rel>(value);
+}
+
+void IpcSignal::OrRelaxed(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpOr, std::memory_order_relaxed>(value);
+}
+
+void IpcSignal::OrAcquire(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpOr, std::memory_order_acquire>(value);
+}
+
+void IpcSignal::OrRelease(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpOr, std::memory_order_release>(value);
+}
+
+void IpcSignal::OrAcqRel(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpOr, std::memory_order_acq_rel>(value);
+}
+
+void IpcSignal::XorRelaxed(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpXor, std::memory_order_relaxed>(value);
+}
+
+void IpcSignal::XorAcquire(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpXor, std::memory_order_acquire>(value);
+}
+
+void IpcSignal::XorRelease(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpXor, std::memory_order_release>(value);
+}
+
+void IpcSignal::XorAcqRel(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpXor, std::memory_order_acq_rel>(value);
+}
+
+void IpcSignal::AddRelaxed(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpAdd, std::memory_order_relaxed>(value);
+}
+
+void IpcSignal::AddAcquire(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpAdd, std::memory_order_acquire>(value);
+}
+
+void IpcSignal::AddRelease(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpAdd, std::memory_order_release>(value);
+}
+
+void IpcSignal::AddAcqRel(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpAdd, std::memory_order_acq_rel>(value);
+}
+
+void IpcSignal::SubRelaxed(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpSub, std::memory_order_relaxed>(value);
+}
+
+void IpcSignal::SubAcquire(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpSub, std::memory_order_acquire>(value);
+}
+
+void IpcSignal::SubRelease(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpSub, std::memory_order_release>(value);
+}
+
+void IpcSignal::SubAcqRel(hsa_signal_value_t value) {
+  ModifyShared<kSignalOpSub, std::memory_order_acq_rel>(value);
+}
+
+hsa_signal_value_t IpcSignal::ExchRelaxed(hsa_signal_value_t value) {
+  hsa_signal_value_t ret = hsa_signal_value_t(
+      atomic::Exchange(value_, int64_t(value), std::memory_order_relaxed));
+  NotifyShared();
+  return ret;
+}
+
+hsa_signal_value_t IpcSignal::ExchAcquire(hsa_signal_value_t value) {
+  hsa_signal_value_t ret = hsa_signal_value_t(
+      atomic::Exchange(value_, int64_t(value), std::memory_order_acquire));
+  NotifyShared();
+  return ret;
+}
+
+hsa_signal_value_t IpcSignal::ExchRelease(hsa_signal_value_t value) {
+  hsa_signal_value_t ret = hsa_signal_value_t(
+      atomic::Exchange(value_, int64_t(value), std::memory_order_release));
+  NotifyShared();
+  return ret;
+}
+
+hsa_signal_value_t IpcSignal::ExchAcqRel(hsa_signal_value_t value) {
+  hsa_signal_value_t ret = hsa_signal_value_t(
+      atomic::Exchange(value_, int64_t(value), std::memory_order_acq_rel));
+  NotifyShared();
+  return ret;
+}
+
+hsa_signal_value_t IpcSignal::CasRelaxed(hsa_signal_value_t expected,
+                                         hsa_signal_value_t value) {
+  hsa_signal_value_t ret = hsa_signal_value_t(atomic::Cas(
+      value_, int64_t(value), int64_t(expected), std::memory_order_relaxed));
+  if (ret == expected) NotifyShared();
+  return ret;
+}
+
+hsa_signal_value_t IpcSignal::CasAcquire(hsa_signal_value_t expected,
+                                         hsa_signal_value_t value) {
+  hsa_signal_value_t ret = hsa_signal_value_t(atomic::Cas(
+      value_, int64_t(value), int64_t(expected), std::memory_order_acquire));
+  if (ret == expected) NotifyShared();
+  return ret;
+}
+
+hsa_signal_value_t IpcSignal::CasRelease(hsa_signal_value_t expected,
+                                         hsa_signal_value_t value) {
+  hsa_signal_value_t ret = hsa_signal_value_t(atomic::Cas(
+      value_, int64_t(value), int64_t(expected), std::memory_order_release));
+  if (ret == expected) NotifyShared();
+  return ret;
+}
+
+hsa_signal_value_t IpcSignal::CasAcqRel(hsa_signal_value_t expected,
+                                        hsa_signal_value_t value) {
+  hsa_signal_value_t ret = hsa_signal_value_t(atomic::Cas(
+      value_, int64_t(value), int64_t(expected), std::memory_order_acq_rel));
+  if (ret == expected) NotifyShared();
+  return ret;
+}
+
+}  // namespace core
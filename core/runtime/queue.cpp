@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+
+#include "core/inc/runtime.h"
+#include "core/inc/queue.h"
+#include "core/inc/signal.h"
+#include "core/util/os.h"
+
+namespace core {
+
+void Queue::Submit(const AqlPacket* packets, uint32_t count) {
+  const uint64_t size = amd_queue_.hsa_queue.size;
+  AqlPacket* ring =
+      reinterpret_cast<AqlPacket*>(amd_queue_.hsa_queue.base_address);
+
+  const uint64_t write = AddWriteIndexRelaxed(count);
+  const uint64_t end = write + count;
+
+  // Wait for the packet processor to free the reserved slots, the cached
+  // read index usually shows enough room already.
+  uint64_t read = atomic::Load(&cached_read_index_, std::memory_order_relaxed);
+  while (end - read > size) {
+    read = LoadReadIndexAcquire();
+    if (end - read > size) os::YieldThread();
+  }
+  if (read > atomic::Load(&cached_read_index_, std::memory_order_relaxed))
+    atomic::Store(&cached_read_index_, read, std::memory_order_relaxed);
+
+  // The header is the first 16 bits of every packet, the slot stays invalid
+  // until it is written.
+  const size_t kHeaderSize = sizeof(hsa_packet_header_t);
+  for (uint32_t i = 0; i < count; i++) {
+    uint8_t* slot = reinterpret_cast<uint8_t*>(&ring[(write + i) & (size - 1)]);
+    memcpy(slot + kHeaderSize,
+           reinterpret_cast<const uint8_t*>(&packets[i]) + kHeaderSize,
+           sizeof(AqlPacket) - kHeaderSize);
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint16_t header = *reinterpret_cast<const uint16_t*>(&packets[i]);
+    atomic::Store(
+        reinterpret_cast<volatile uint16_t*>(&ring[(write + i) & (size - 1)]),
+        header, std::memory_order_release);
+  }
+
+  Signal* doorbell = Signal::Convert(amd_queue_.hsa_queue.doorbell_signal);
+  doorbell->StoreRelease(hsa_signal_value_t(end - 1));
+}
+
+}  // namespace core
@@ -53,6 +53,8 @@
 #include "core/inc/hsa_ext_interface.h"
 #include "core/inc/amd_memory_registration.h"
 #include "core/inc/amd_topology.h"
+#include "core/inc/hybrid_signal.h"
+#include "core/inc/signal.h"
 #include "core/inc/thunk.h"
 
 #include "inc/hsa_api_trace.h"
@@ -62,6 +64,8 @@
 
 namespace core {
 bool g_use_interrupt_wait = false;
+bool g_use_hybrid_wait = false;
+bool g_signal_stats = false;
 
 Runtime* Runtime::runtime_singleton_ = NULL;
 
@@ -199,18 +203,12 @@ hsa_status_t Runtime::GetSystemInfo(hsa_system_info_t attribute, void* value) {
     case HSA_SYSTEM_INFO_VERSION_MINOR:
       *((uint16_t*)value) = HSA_VERSION_MINOR;
       break;
-    case HSA_SYSTEM_INFO_TIMESTAMP: {
-      HsaClockCounters clocks;
-      hsaKmtGetClockCounters(0, &clocks);
-      *((uint64_t*)value) = clocks.SystemClockCounter;
+    case HSA_SYSTEM_INFO_TIMESTAMP:
+      *((uint64_t*)value) = system_clock_.Timestamp();
       break;
-    }
-    case HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY: {
-      HsaClockCounters clocks;
-      hsaKmtGetClockCounters(0, &clocks);
-      *(uint64_t*)value = clocks.SystemClockFrequencyHz;
+    case HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY:
+      *(uint64_t*)value = system_clock_.Frequency();
       break;
-    }
     case HSA_SYSTEM_INFO_SIGNAL_MAX_WAIT:
       *((uint64_t*)value) = 0xFFFFFFFFFFFFFFFF;
       break;
@@ -308,22 +306,220 @@ void Runtime::DeregisterWithDrivers(void* ptr) {
   amd::DeregisterKfdMemory(ptr);
 }
 
+hsa_status_t Runtime::SetAsyncSignalHandler(hsa_signal_t signal,
+                                            hsa_signal_condition_t cond,
+                                            hsa_signal_value_t value,
+                                            hsa_amd_signal_handler handler,
+                                            void* arg,
+                                            hsa_amd_signal_cancel_handler
+                                                cancel) {
+  // Start the async events thread on first use.
+  {
+    ScopedAcquire<KernelMutex> lock(&async_events_control_.lock);
+    if (async_events_control_.async_events_thread_ == NULL) {
+      // A hybrid wake signal keeps the thread blocked in the kernel while
+      // every watched signal can provide a KFD event.
+      Signal* wake = new HybridSignal(0);
+      if (wake == NULL) return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+      async_events_control_.wake = Signal::Convert(wake);
+      async_events_.PushBack(async_events_control_.wake, HSA_NE, 0, NULL,
+                             NULL, NULL);
+      async_events_control_.exit = false;
+      async_events_control_.async_events_thread_ =
+          os::CreateThread(AsyncEventsLoop, NULL);
+      if (async_events_control_.async_events_thread_ == NULL) {
+        async_events_.Clear();
+        hsa_signal_destroy(async_events_control_.wake);
+        async_events_control_.wake = 0;
+        return HSA_STATUS_ERROR_OUT_OF_RESOURCES;
+      }
+    }
+  }
+
+  // The handler keeps the signal from being deleted until it is dropped.
+  Signal::Convert(signal)->Retain();
+
+  ScopedAcquire<KernelMutex> lock(&new_async_events_.lock_);
+  new_async_events_.PushBack(signal, cond, value, handler, arg, cancel);
+  hsa_signal_store_release(async_events_control_.wake, 1);
+  return HSA_STATUS_SUCCESS;
+}
+
+void Runtime::SetAgentDispatchHandler(uint16_t type,
+                                      hsa_amd_agent_dispatch_handler handler,
+                                      void* data) {
+  ScopedAcquire<KernelMutex> lock(&agent_dispatch_lock_);
+  if (handler == NULL) {
+    agent_dispatch_handlers_.erase(type);
+    return;
+  }
+  AgentDispatchHandler& entry = agent_dispatch_handlers_[type];
+  entry.handler = handler;
+  entry.data = data;
+}
+
+bool Runtime::GetAgentDispatchHandler(uint16_t type,
+                                      hsa_amd_agent_dispatch_handler* handler,
+                                      void** data) {
+  ScopedAcquire<KernelMutex> lock(&agent_dispatch_lock_);
+  std::map<uint16_t, AgentDispatchHandler>::const_iterator it =
+      agent_dispatch_handlers_.find(type);
+  if (it == agent_dispatch_handlers_.end()) return false;
+  *handler = it->second.handler;
+  *data = it->second.data;
+  return true;
+}
+
+void Runtime::AsyncEventsLoop(void*) {
+  AsyncEventsControl& control = runtime_singleton_->async_events_control_;
+  AsyncEvents& events = runtime_singleton_->async_events_;
+  AsyncEvents& new_events = runtime_singleton_->new_async_events_;
+
+  while (!control.exit) {
+    hsa_signal_value_t value;
+    uint32_t index = Signal::WaitAny(
+        uint32_t(events.Size()), &events.signal_[0], &events.cond_[0],
+        &events.value_[0], uint64_t(-1), HSA_WAIT_EXPECTANCY_LONG, &value);
+
+    if (index == 0) {
+      // Woken to pick up new handlers or to exit.
+      hsa_signal_store_relaxed(control.wake, 0);
+    } else if (index != UINT32_MAX) {
+      // Drop the handler unless it asks to be called again.
+      if (!events.handler_[index](value, events.arg_[index]))
+        events.Remove(index, false);
+    } else {
+      // A watched signal was destroyed, forget its handler. The reference
+      // held for the handler keeps the signal readable until released.
+      for (size_t i = events.Size() - 1; i != 0; i--) {
+        if (Signal::Convert(events.signal_[i])->IsRetired())
+          events.Remove(i, true);
+      }
+    }
+
+    // Insert handlers registered while waiting.
+    ScopedAcquire<KernelMutex> lock(&new_events.lock_);
+    for (size_t i = 0; i < new_events.Size(); i++)
+      events.PushBack(new_events.signal_[i], new_events.cond_[i],
+                      new_events.value_[i], new_events.handler_[i],
+                      new_events.arg_[i], new_events.cancel_[i]);
+    new_events.Clear();
+  }
+}
+
+void Runtime::StopAsyncEvents() {
+  {
+    ScopedAcquire<KernelMutex> lock(&async_events_control_.lock);
+    if (async_events_control_.async_events_thread_ == NULL) return;
+
+    async_events_control_.exit = true;
+    hsa_signal_store_release(async_events_control_.wake, 1);
+    os::WaitForThread(async_events_control_.async_events_thread_);
+    async_events_control_.async_events_thread_ = NULL;
+
+    hsa_signal_destroy(async_events_control_.wake);
+    async_events_control_.wake = 0;
+  }
+
+  async_events_.RemoveFrom(1);
+  async_events_.Clear();
+  ScopedAcquire<KernelMutex> lock(&new_async_events_.lock_);
+  new_async_events_.RemoveFrom(0);
+}
+
+void Runtime::AsyncEvents::PushBack(hsa_signal_t signal,
+                                    hsa_signal_condition_t cond,
+                                    hsa_signal_value_t value,
+                                    hsa_amd_signal_handler handler,
+                                    void* arg,
+                                    hsa_amd_signal_cancel_handler cancel) {
+  signal_.push_back(signal);
+  cond_.push_back(cond);
+  value_.push_back(value);
+  handler_.push_back(handler);
+  arg_.push_back(arg);
+  cancel_.push_back(cancel);
+}
+
+void Runtime::AsyncEvents::CopyIndex(size_t dst, size_t src) {
+  signal_[dst] = signal_[src];
+  cond_[dst] = cond_[src];
+  value_[dst] = value_[src];
+  handler_[dst] = handler_[src];
+  arg_[dst] = arg_[src];
+  cancel_[dst] = cancel_[src];
+}
+
+void Runtime::AsyncEvents::PopBack() {
+  signal_.pop_back();
+  cond_.pop_back();
+  value_.pop_back();
+  handler_.pop_back();
+  arg_.pop_back();
+  cancel_.pop_back();
+}
+
+void Runtime::AsyncEvents::Remove(size_t index, bool cancel) {
+  Signal* signal = Signal::Convert(signal_[index]);
+  hsa_amd_signal_cancel_handler cancel_fn = (cancel) ? cancel_[index] : NULL;
+  void* arg = arg_[index];
+  CopyIndex(index, Size() - 1);
+  PopBack();
+  signal->Release();
+  if (cancel_fn != NULL) cancel_fn(arg);
+}
+
+void Runtime::AsyncEvents::RemoveFrom(size_t first) {
+  while (Size() > first) Remove(Size() - 1, true);
+}
+
+void Runtime::AsyncEvents::Clear() {
+  signal_.clear();
+  cond_.clear();
+  value_.clear();
+  handler_.clear();
+  arg_.clear();
+  cancel_.clear();
+}
+
 void Runtime::Load() {
   // Load interrupt enable option
   std::string interrupt = os::GetEnvVar("HSA_ENABLE_INTERRUPT");
   g_use_interrupt_wait = (interrupt == "1");
 
+  // Load hybrid wait option, signals attach interrupts on demand if it is set
+  std::string hybrid = os::GetEnvVar("HSA_ENABLE_HYBRID_WAIT");
+  g_use_hybrid_wait = (hybrid == "1");
+
+  // Load signal wait statistics option
+  std::string stats = os::GetEnvVar("HSA_SIGNAL_STATS");
+  g_signal_stats = (stats == "1");
+
+  // Per thread signal caches are on unless explicitly disabled
+  std::string signal_cache = os::GetEnvVar("HSA_SIGNAL_THREAD_CACHE");
+  signal_pool_.EnableThreadCache(signal_cache != "0");
+
   amd::Load();
 
+  system_clock_.Start();
+
+  // Wait budgets are measured against the calibrated clock
+  WaitPolicy::LoadSettings();
+  std::string monitor = os::GetEnvVar("HSA_DISABLE_MONITOR_WAIT");
+  SpinWait::Init(system_clock_.TscFrequency(), monitor != "1");
+
   // Load tools libraries
   LoadTools();
 }
 
 void Runtime::Unload() {
+  StopAsyncEvents();
   UnloadTools();
   DestroyAgents();
   CloseTools();
   extensions_.Unload();
+  system_clock_.Stop();
+  event_pool_.Clear();
   amd::Unload();
 }
 
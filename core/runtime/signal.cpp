@@ -0,0 +1,322 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "core/inc/signal.h"
+
+#include <string.h>
+
+#include <new>
+#include <vector>
+
+namespace core {
+
+volatile uint32_t Signal::multi_waiters_ = 0;
+volatile uint32_t Signal::multi_wait_word_ = 0;
+volatile uint64_t Signal::wait_histogram_[Signal::kWaitHistogramBuckets];
+
+bool Signal::HostMayWait(uint32_t num_consumers,
+                         const hsa_agent_t* consumers) {
+  // No list means any agent may consume the signal.
+  if (num_consumers == 0) return true;
+  for (uint32_t i = 0; i < num_consumers; i++) {
+    const Agent* agent = Agent::Convert(consumers[i]);
+    if (agent == NULL || !agent->IsValid() ||
+        agent->device_type() == Agent::kAmdCpuDevice)
+      return true;
+  }
+  return false;
+}
+
+void Signal::GetStats(hsa_amd_signal_stats_t* stats) const {
+  const SignalStats* source =
+      atomic::Load(&stats_, std::memory_order_acquire);
+  if (source == NULL) {
+    memset(stats, 0, sizeof(hsa_amd_signal_stats_t));
+    return;
+  }
+  stats->wait_count = atomic::Load(&source->wait_count);
+  stats->timeout_count = atomic::Load(&source->timeout_count);
+  stats->wait_time_ns = atomic::Load(&source->wait_time_ns);
+  stats->blocked_time_ns = atomic::Load(&source->blocked_time_ns);
+  stats->spin_count = atomic::Load(&source->spin_count);
+  stats->block_count = atomic::Load(&source->block_count);
+  stats->notified_wake_count = atomic::Load(&source->notified_wake_count);
+  stats->timed_wake_count = atomic::Load(&source->timed_wake_count);
+}
+
+void Signal::GetWaitHistogram(uint64_t* buckets, uint32_t bucket_count) {
+  for (uint32_t i = 0; i < bucket_count; i++)
+    buckets[i] =
+        (i < kWaitHistogramBuckets) ? atomic::Load(&wait_histogram_[i]) : 0;
+}
+
+void Signal::WaitRecord::Publish() {
+  const SystemClock& clock = Runtime::runtime_singleton_->system_clock();
+  uint64_t wait_ns = clock.TicksToNs(Now() - start_);
+  uint64_t blocked_ns = clock.TicksToNs(blocked_ticks_);
+
+  uint32_t bucket = (wait_ns == 0) ? 0 : 63 - __builtin_clzll(wait_ns);
+  bucket = Min(bucket, kWaitHistogramBuckets - 1);
+  atomic::Increment(&wait_histogram_[bucket]);
+
+  if (signal_ == NULL) return;
+
+  // Install the signal's statistics on first use.
+  SignalStats* stats =
+      atomic::Load(&signal_->stats_, std::memory_order_acquire);
+  if (stats == NULL) {
+    SignalStats* fresh = new (std::nothrow) SignalStats();
+    if (fresh == NULL) return;
+    stats = atomic::Cas(&signal_->stats_, fresh, (SignalStats*)NULL,
+                        std::memory_order_acq_rel);
+    if (stats != NULL) {
+      delete fresh;
+    } else {
+      stats = fresh;
+    }
+  }
+
+  atomic::Increment(&stats->wait_count);
+  if (timed_out_) atomic::Increment(&stats->timeout_count);
+  atomic::Add(&stats->wait_time_ns, wait_ns);
+  atomic::Add(&stats->blocked_time_ns, blocked_ns);
+  atomic::Add(&stats->spin_count, spins_);
+  atomic::Add(&stats->block_count, blocks_);
+  atomic::Add(&stats->notified_wake_count, notified_wakes_);
+  atomic::Add(&stats->timed_wake_count, blocks_ - notified_wakes_);
+}
+
+uint32_t Signal::WaitAny(uint32_t signal_count,
+                         const hsa_signal_t* hsa_signals,
+                         const hsa_signal_condition_t* conds,
+                         const hsa_signal_value_t* values, uint64_t timeout,
+                         hsa_wait_expectancy_t wait_hint,
+                         hsa_signal_value_t* satisfying_value) {
+  return WaitMultiple(false, signal_count, hsa_signals, conds, values, timeout,
+                      wait_hint, satisfying_value);
+}
+
+uint32_t Signal::WaitAll(uint32_t signal_count,
+                         const hsa_signal_t* hsa_signals,
+                         const hsa_signal_condition_t* conds,
+                         const hsa_signal_value_t* values, uint64_t timeout,
+                         hsa_wait_expectancy_t wait_hint,
+                         hsa_signal_value_t* satisfying_values) {
+  return WaitMultiple(true, signal_count, hsa_signals, conds, values, timeout,
+                      wait_hint, satisfying_values);
+}
+
+bool Signal::Retire() {
+  invalid_ = true;
+  uint32_t waiters = atomic::Or(&waiting_, kRetired, std::memory_order_acq_rel);
+  if (waiters == 0) return true;
+
+  // Waiters observe invalid_ once woken and the last one deletes the signal.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  Notify();
+  return false;
+}
+
+uint32_t Signal::WaitMultiple(bool wait_all, uint32_t signal_count,
+                              const hsa_signal_t* hsa_signals,
+                              const hsa_signal_condition_t* conds,
+                              const hsa_signal_value_t* values,
+                              uint64_t timeout,
+                              hsa_wait_expectancy_t wait_hint,
+                              hsa_signal_value_t* satisfying_values) {
+  const uint32_t kNotSatisfied = UINT32_MAX;
+  if (signal_count == 0) return (wait_all) ? 0 : kNotSatisfied;
+
+  std::vector<Signal*> signals(signal_count);
+  std::vector<hsa_signal_value_t*> locations(signal_count);
+  std::vector<bool> satisfied(signal_count, false);
+  std::vector<HsaEvent*> signal_events(signal_count, NULL);
+  std::vector<HsaEvent*> events;
+  events.reserve(signal_count);
+
+  for (uint32_t i = 0; i < signal_count; i++) {
+    signals[i] = Convert(hsa_signals[i]);
+    locations[i] = signals[i]->ValueLocation();
+  }
+
+  // Blocking on KFD events is only possible when every signal has one. They
+  // are acquired when first blocking since hybrid signals attach them then.
+  bool events_acquired = false;
+  bool all_events = false;
+
+  // Publish the waiter on every signal so that their mutators notify, then
+  // on the shared word, before sampling any value.
+  for (uint32_t i = 0; i < signal_count; i++) signals[i]->AddWaiter();
+  atomic::Increment(&multi_waiters_, std::memory_order_seq_cst);
+  MAKE_SCOPE_GUARD([&]() {
+    // Pass wakeups on to waiters which were not yet blocked when an event was
+    // set, as InterruptSignal::WaitRelaxed does.
+    if (all_events) {
+      for (uint32_t i = 0; i < signal_count; i++) {
+        if (signals[i]->Waiters() != 1) hsaKmtSetEvent(signal_events[i]);
+        signals[i]->ReleaseEvent();
+      }
+    }
+    atomic::Decrement(&multi_waiters_);
+    for (uint32_t i = 0; i < signal_count; i++) signals[i]->RemoveWaiter();
+  });
+  WaitRecord record(NULL);
+  WaitPolicy policy(wait_hint, NULL);
+  SpinWait spin;
+
+  const bool infinite = (timeout == uint64_t(-1));
+  const SystemClock& clock = Runtime::runtime_singleton_->system_clock();
+  uint64_t start_time = 0, sys_time;
+  if (!infinite) start_time = clock.Timestamp();
+
+  // Bounds the first block after acquiring events, for device writes which
+  // missed a mailbox being attached, and blocks while other threads wait on
+  // one of the events, in case a wakeup was consumed before this thread
+  // blocked.
+  const uint32_t kBoundedWaitMs = 1;
+  bool first_block = true;
+
+  // Parks are bounded since device writes and writes to signals without
+  // multi-waiter support do not bump the shared word.
+  const uint64_t kMinParkNs = 20000;
+  const uint64_t kMaxParkNs = 1000000;
+  uint64_t park_ns = kMinParkNs;
+
+  uint32_t satisfied_count = 0;
+  while (true) {
+    // Sample the shared word before the values so that any change made after
+    // the scan below fails the futex compare.
+    uint32_t generation =
+        atomic::Load(&multi_wait_word_, std::memory_order_seq_cst);
+
+    for (uint32_t i = 0; i < signal_count; i++) {
+      if (signals[i]->IsRetired())
+        return (wait_all) ? satisfied_count : kNotSatisfied;
+      if (satisfied[i]) continue;
+
+      hsa_signal_value_t value =
+          atomic::Load(locations[i], std::memory_order_relaxed);
+      if (!CheckCondition(conds[i], value, values[i])) continue;
+
+      if (!wait_all) {
+        if (satisfying_values != NULL) *satisfying_values = value;
+        return i;
+      }
+      if (satisfying_values != NULL) satisfying_values[i] = value;
+      satisfied[i] = true;
+      satisfied_count++;
+    }
+    if (satisfied_count == signal_count) return satisfied_count;
+
+    WaitPolicy::Phase phase = policy.Next();
+    if (phase == WaitPolicy::kSpin) {
+      record.Spin();
+      spin.Pause();
+      continue;
+    }
+
+    uint64_t remaining_ns = kMaxParkNs;
+    if (!infinite) {
+      sys_time = clock.Timestamp();
+      if (sys_time - start_time > timeout) {
+        record.Timeout();
+        return (wait_all) ? satisfied_count : kNotSatisfied;
+      }
+      remaining_ns = clock.TicksToNs(timeout - (sys_time - start_time));
+    }
+
+    if (phase == WaitPolicy::kYield) {
+      os::YieldThread();
+      continue;
+    }
+
+    if (!events_acquired) {
+      events_acquired = true;
+      uint32_t acquired = 0;
+      while (acquired < signal_count) {
+        signal_events[acquired] = signals[acquired]->AcquireEvent();
+        if (signal_events[acquired] == NULL) break;
+        acquired++;
+      }
+      all_events = (acquired == signal_count);
+      // Sample the values again before blocking. Without a full set the
+      // events would only cost interrupts, parks poll instead.
+      if (all_events) continue;
+      while (acquired != 0) signals[--acquired]->ReleaseEvent();
+    }
+
+    if (all_events) {
+      events.clear();
+      bool shared = false;
+      for (uint32_t i = 0; i < signal_count; i++) {
+        if (satisfied[i]) continue;
+        events.push_back(signal_events[i]);
+        if (signals[i]->Waiters() > 1) shared = true;
+      }
+      // Rounded up, a zero timeout would spin on the syscall until the
+      // deadline.
+      uint32_t wait_ms = uint32_t(-1);
+      if (!infinite)
+        wait_ms = uint32_t(
+            Min((remaining_ns + 999999) / 1000000, uint64_t(UINT32_MAX - 1)));
+      if (first_block || shared) wait_ms = Min(wait_ms, kBoundedWaitMs);
+      first_block = false;
+      record.BlockBegin();
+      HSAKMT_STATUS err = hsaKmtWaitOnMultipleEvents(
+          &events[0], uint32_t(events.size()), false, wait_ms);
+      record.BlockEnd(err != HSAKMT_STATUS_WAIT_TIMEOUT);
+    } else {
+      record.BlockBegin();
+      bool notified =
+          os::WaitOnAddress(&multi_wait_word_, generation,
+                            Max(Min(park_ns, remaining_ns), uint64_t(1)));
+      record.BlockEnd(notified);
+      park_ns = Min(park_ns * 2, kMaxParkNs);
+    }
+  }
+}
+
+}  // namespace core
@@ -0,0 +1,220 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "core/inc/signal_pool.h"
+
+#include <algorithm>
+
+#include "inc/hsa.h"
+
+namespace core {
+
+/// @brief Free blocks cached by one thread.
+class SignalPool::ThreadCache {
+ public:
+  ThreadCache() : pool_(NULL), head_(NULL), count_(0) {}
+
+  /// @brief Returns the cached blocks when the thread exits.
+  ~ThreadCache() {
+    ScopedAcquire<KernelMutex> lock(&SignalPool::cache_lock_);
+    if (pool_ != NULL) pool_->DetachCache(this);
+  }
+
+  SignalPool* pool_;
+  Block* head_;
+  uint32_t count_;
+};
+
+thread_local SignalPool::ThreadCache SignalPool::thread_cache_;
+
+KernelMutex SignalPool::cache_lock_;
+
+SignalPool::SignalPool() : free_list_(NULL), thread_cache_enabled_(true) {}
+
+SignalPool::~SignalPool() {
+  ScopedAcquire<KernelMutex> cache_lock(&cache_lock_);
+  ScopedAcquire<KernelMutex> lock(&lock_);
+  for (size_t i = 0; i < caches_.size(); i++) {
+    caches_[i]->pool_ = NULL;
+    caches_[i]->head_ = NULL;
+    caches_[i]->count_ = 0;
+  }
+  caches_.clear();
+  for (size_t i = 0; i < slabs_.size(); i++) {
+    hsa_memory_deregister(slabs_[i].base, slabs_[i].size);
+    _aligned_free(slabs_[i].base);
+  }
+  slabs_.clear();
+  free_list_ = NULL;
+}
+
+void* SignalPool::Alloc(size_t size) {
+  assert(size <= kBlockSize && "Object does not fit in a signal pool block.");
+  if (size > kBlockSize) return NULL;
+
+  if (thread_cache_enabled_) {
+    ThreadCache& cache = thread_cache_;
+    if (cache.pool_ == this && cache.head_ != NULL) {
+      Block* block = cache.head_;
+      cache.head_ = block->next;
+      cache.count_--;
+      return block;
+    }
+  }
+
+  ScopedAcquire<KernelMutex> lock(&lock_);
+  if (free_list_ == NULL && !Grow()) return NULL;
+  Block* block = free_list_;
+  free_list_ = block->next;
+  return block;
+}
+
+void SignalPool::Free(void* ptr) {
+  if (ptr == NULL) return;
+  Block* block = reinterpret_cast<Block*>(ptr);
+
+  if (thread_cache_enabled_) {
+    ThreadCache& cache = thread_cache_;
+    if (cache.pool_ == NULL) AttachCache(&cache);
+    if (cache.pool_ == this) {
+      block->next = cache.head_;
+      cache.head_ = block;
+      if (++cache.count_ > kThreadCacheBlocks) {
+        ScopedAcquire<KernelMutex> lock(&lock_);
+        Reclaim(&cache, kThreadCacheBlocks / 2);
+      }
+      return;
+    }
+  }
+
+  ScopedAcquire<KernelMutex> lock(&lock_);
+  block->next = free_list_;
+  free_list_ = block;
+}
+
+bool SignalPool::AllocBatch(size_t size, uint32_t count, void** blocks) {
+  assert(size <= kBlockSize && "Object does not fit in a signal pool block.");
+  if (size > kBlockSize) return false;
+
+  ScopedAcquire<KernelMutex> lock(&lock_);
+  for (uint32_t i = 0; i < count; i++) {
+    if (free_list_ == NULL) {
+      size_t remaining = size_t(count - i) * kBlockSize;
+      size_t slab_size = (remaining + kSlabSize - 1) / kSlabSize * kSlabSize;
+      if (!Grow(slab_size)) {
+        // Undo in reverse so the free list keeps its order.
+        while (i != 0) {
+          Block* block = reinterpret_cast<Block*>(blocks[--i]);
+          block->next = free_list_;
+          free_list_ = block;
+        }
+        return false;
+      }
+    }
+    Block* block = free_list_;
+    free_list_ = block->next;
+    blocks[i] = block;
+  }
+  return true;
+}
+
+void SignalPool::FreeBatch(void* const* blocks, uint32_t count) {
+  ScopedAcquire<KernelMutex> lock(&lock_);
+  for (uint32_t i = count; i != 0; i--) {
+    Block* block = reinterpret_cast<Block*>(blocks[i - 1]);
+    block->next = free_list_;
+    free_list_ = block;
+  }
+}
+
+bool SignalPool::Grow(size_t size) {
+  void* slab = _aligned_malloc(size, kSlabAlignment);
+  if (slab == NULL) return false;
+
+  if (hsa_memory_register(slab, size) != HSA_STATUS_SUCCESS) {
+    _aligned_free(slab);
+    return false;
+  }
+  Slab record = {slab, size};
+  slabs_.push_back(record);
+
+  // Link in reverse so that blocks are handed out in address order.
+  char* base = reinterpret_cast<char*>(slab);
+  for (size_t offset = size; offset != 0; offset -= kBlockSize) {
+    Block* block = reinterpret_cast<Block*>(base + offset - kBlockSize);
+    block->next = free_list_;
+    free_list_ = block;
+  }
+  return true;
+}
+
+void SignalPool::AttachCache(ThreadCache* cache) {
+  ScopedAcquire<KernelMutex> cache_lock(&cache_lock_);
+  ScopedAcquire<KernelMutex> lock(&lock_);
+  caches_.push_back(cache);
+  cache->pool_ = this;
+}
+
+void SignalPool::DetachCache(ThreadCache* cache) {
+  ScopedAcquire<KernelMutex> lock(&lock_);
+  Reclaim(cache, cache->count_);
+  caches_.erase(std::remove(caches_.begin(), caches_.end(), cache),
+                caches_.end());
+  cache->pool_ = NULL;
+}
+
+void SignalPool::Reclaim(ThreadCache* cache, uint32_t count) {
+  while (count != 0 && cache->head_ != NULL) {
+    Block* block = cache->head_;
+    cache->head_ = block->next;
+    block->next = free_list_;
+    free_list_ = block;
+    cache->count_--;
+    count--;
+  }
+}
+
+}  // namespace core
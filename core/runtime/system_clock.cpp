@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "core/inc/system_clock.h"
+
+#include <cpuid.h>
+
+#include "core/inc/thunk.h"
+
+namespace core {
+
+SystemClock::SystemClock()
+    : seq_(0),
+      tsc_base_(0),
+      counter_base_(0),
+      scale_(0),
+      tsc_origin_(0),
+      counter_origin_(0),
+      frequency_(1),
+      tsc_frequency_(0),
+      ns_per_tick_(1.0),
+      use_tsc_(false),
+      thread_(NULL),
+      stop_(0) {}
+
+SystemClock::~SystemClock() { Stop(); }
+
+void SystemClock::Start() {
+  HsaClockCounters clocks;
+  hsaKmtGetClockCounters(0, &clocks);
+  frequency_ = Max(clocks.SystemClockFrequencyHz, uint64_t(1));
+  ns_per_tick_ = 1000000000.0 / double(frequency_);
+
+  // The TSC can only stand in for the system clock if it ticks at a constant
+  // rate in all P, C and T states.
+  unsigned int eax, ebx, ecx, edx;
+  use_tsc_ = false;
+  if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+    use_tsc_ = ((edx & (1u << 8)) != 0);
+  if (os::GetEnvVar("HSA_DISABLE_TSC_CLOCK") == "1") use_tsc_ = false;
+
+  // Initial rate from a short interval, refined by the background thread.
+  // The TSC rate is measured even when the TSC is not used for timestamps
+  // since waits time their spin phases with it.
+  Sample(tsc_origin_, counter_origin_);
+  os::Sleep(1);
+  uint64_t tsc, counter;
+  Sample(tsc, counter);
+  if (tsc == tsc_origin_ || counter == counter_origin_) {
+    use_tsc_ = false;
+    return;
+  }
+  double rate = double(counter - counter_origin_) / double(tsc - tsc_origin_);
+  tsc_frequency_ = uint64_t(double(frequency_) / rate);
+  if (!use_tsc_) return;
+
+  BeginPublish();
+  EndPublish(tsc, counter, uint64_t(rate * double(1ull << kScaleShift)));
+
+  stop_ = 0;
+  thread_ = os::CreateThread(CalibrationLoop, this);
+}
+
+void SystemClock::Stop() {
+  if (thread_ == NULL) return;
+  atomic::Store(&stop_, 1u, std::memory_order_release);
+  os::WakeByAddress(&stop_, 1);
+  os::WaitForThread(thread_);
+  thread_ = NULL;
+}
+
+uint64_t SystemClock::QueryCounter() {
+  HsaClockCounters clocks;
+  hsaKmtGetClockCounters(0, &clocks);
+  return clocks.SystemClockCounter;
+}
+
+void SystemClock::Sample(uint64_t& tsc, uint64_t& counter) {
+  uint64_t before = __rdtsc();
+  counter = QueryCounter();
+  uint64_t after = __rdtsc();
+  tsc = before + (after - before) / 2;
+}
+
+void SystemClock::Calibrate(uint64_t horizon_ns) {
+  uint64_t tsc, counter;
+  Sample(tsc, counter);
+  if (tsc == tsc_origin_) return;
+
+  // Long term rate, accurate to the sampling jitter over the whole run time.
+  double rate = double(counter - counter_origin_) / double(tsc - tsc_origin_);
+  if (rate <= 0) return;
+  double period_tsc = double(horizon_ns) / ns_per_tick_ / rate;
+
+  // Continue from the timestamp extrapolated at a TSC read taken with the
+  // sequence lock held. Readers sample the TSC inside the lock, so every
+  // timestamp returned with the old parameters is at most this base and the
+  // timestamp neither jumps nor goes backwards. This is the only writer, the
+  // parameters are read without the lock.
+  BeginPublish();
+  uint64_t base_tsc = __rdtsc();
+  uint64_t current = counter_base_ + ScaleTicks(base_tsc - tsc_base_, scale_);
+
+  // Pick the slope which reaches the measured clock one period from now.
+  double target =
+      double(counter) + rate * (double(base_tsc - tsc) + period_tsc);
+  double slope = (target - double(current)) / period_tsc;
+  slope = Max(slope, rate / 2);
+  slope = Min(slope, rate * 2);
+
+  EndPublish(base_tsc, current, uint64_t(slope * double(1ull << kScaleShift)));
+}
+
+void SystemClock::BeginPublish() {
+  atomic::Store(&seq_, seq_ + 1, std::memory_order_relaxed);
+  // Full fence, the TSC is not read before the odd sequence is visible.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void SystemClock::EndPublish(uint64_t tsc_base, uint64_t counter_base,
+                             uint64_t scale) {
+  atomic::Store(&tsc_base_, tsc_base, std::memory_order_relaxed);
+  atomic::Store(&counter_base_, counter_base, std::memory_order_relaxed);
+  atomic::Store(&scale_, scale, std::memory_order_relaxed);
+  atomic::Store(&seq_, seq_ + 1, std::memory_order_release);
+}
+
+void SystemClock::CalibrationLoop(void* clock) {
+  SystemClock* self = reinterpret_cast<SystemClock*>(clock);
+
+  // Re-calibrate quickly at first, then settle to once a second.
+  const uint64_t kMaxPeriodNs = 1000000000;
+  uint64_t period_ns = 10000000;
+  while (atomic::Load(&self->stop_, std::memory_order_acquire) == 0) {
+    os::WaitOnAddress(&self->stop_, 0, period_ns);
+    if (atomic::Load(&self->stop_, std::memory_order_acquire) != 0) break;
+    period_ns = Min(period_ns * 4, kMaxPeriodNs);
+    self->Calibrate(period_ns);
+  }
+}
+
+}  // namespace core
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "core/inc/wait_policy.h"
+
+#include <stdlib.h>
+
+#include "core/inc/runtime.h"
+#include "core/util/atomic_helpers.h"
+#include "core/util/os.h"
+
+namespace core {
+
+uint64_t WaitPolicy::max_spin_ticks_ = 200000;
+uint64_t WaitPolicy::min_spin_ticks_ = 8000;
+uint64_t WaitPolicy::yield_ticks_per_wait_ = 80000;
+uint64_t WaitPolicy::ticks_per_us_ = 4000;
+
+// Reads a budget in microseconds from the environment.
+static uint64_t GetBudgetUs(const char* name, uint64_t default_us) {
+  std::string var = os::GetEnvVar(name);
+  if (var.empty()) return default_us;
+  return strtoull(var.c_str(), NULL, 0);
+}
+
+void WaitPolicy::LoadSettings() {
+  // Without a measured rate assume 4GHz, budgets need not be exact.
+  uint64_t frequency =
+      Runtime::runtime_singleton_->system_clock().TscFrequency();
+  if (frequency >= 1000000) ticks_per_us_ = frequency / 1000000;
+
+  max_spin_ticks_ = GetBudgetUs("HSA_WAIT_SPIN_US", 50) * ticks_per_us_;
+  min_spin_ticks_ = GetBudgetUs("HSA_WAIT_MIN_SPIN_US", 2) * ticks_per_us_;
+  min_spin_ticks_ = Min(min_spin_ticks_, max_spin_ticks_);
+  yield_ticks_per_wait_ = GetBudgetUs("HSA_WAIT_YIELD_US", 20) * ticks_per_us_;
+}
+
+WaitPolicy::WaitPolicy(hsa_wait_expectancy_t hint, volatile uint32_t* history)
+    : history_(history), start_(__rdtsc()) {
+  switch (hint) {
+    case HSA_WAIT_EXPECTANCY_SHORT:
+      spin_ticks_ = max_spin_ticks_;
+      yield_ticks_ = UINT64_MAX;
+      break;
+    case HSA_WAIT_EXPECTANCY_LONG:
+      spin_ticks_ = min_spin_ticks_;
+      yield_ticks_ = spin_ticks_;
+      break;
+    default: {
+      // Spin for twice the typical wait when that fits the budget. Waits
+      // which typically outlast the budget would only burn the CPU.
+      uint64_t typical_ticks =
+          (history_ == NULL) ? 0 : uint64_t(*history_) * ticks_per_us_;
+      if (typical_ticks == 0)
+        spin_ticks_ = max_spin_ticks_;
+      else if (typical_ticks * 2 <= max_spin_ticks_)
+        spin_ticks_ = Max(typical_ticks * 2, min_spin_ticks_);
+      else
+        spin_ticks_ = min_spin_ticks_;
+      yield_ticks_ = spin_ticks_ + yield_ticks_per_wait_;
+      break;
+    }
+  }
+}
+
+void WaitPolicy::Satisfied() {
+  if (history_ == NULL) return;
+
+  // Exponential moving average of the wait duration in microseconds, at
+  // least 1 once there is any history. Races between waiters only lose
+  // samples.
+  uint64_t sample = uint64_t(__rdtsc() - start_) / ticks_per_us_;
+  sample = Max(Min(sample, uint64_t(UINT32_MAX)), uint64_t(1));
+  int64_t average = int64_t(*history_);
+  if (average == 0)
+    average = int64_t(sample);
+  else
+    average += (int64_t(sample) - average) / 8;
+  atomic::Store(history_, uint32_t(Max(average, int64_t(1))),
+                std::memory_order_relaxed);
+}
+
+}  // namespace core
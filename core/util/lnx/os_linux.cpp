@@ -53,6 +53,18 @@
 #include "unistd.h"
 #include "sched.h"
 #include <pthread.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
 
 namespace os {
 
@@ -101,6 +113,67 @@ void Sleep(int delay_in_millisec) { usleep(delay_in_millisec * 1000); }
 
 void YieldThread() { sched_yield(); }
 
+bool WaitOnAddress(volatile uint32_t* address, uint32_t expected,
+                   uint64_t timeout_ns, bool shared) {
+  timespec timeout;
+  timeout.tv_sec = time_t(timeout_ns / 1000000000);
+  timeout.tv_nsec = long(timeout_ns % 1000000000);
+  int op = (shared) ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE;
+  int ret = syscall(SYS_futex, address, op, expected, &timeout, NULL, 0);
+  return !((ret == -1) && (errno == ETIMEDOUT));
+}
+
+void WakeByAddress(volatile uint32_t* address, uint32_t count, bool shared) {
+  int op = (shared) ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE;
+  syscall(SYS_futex, address, op, int(Min(count, uint32_t(INT_MAX))), NULL,
+          NULL, 0);
+}
+
+int CreateSharedMemory(size_t size, bool huge_pages) {
+  unsigned int flags = MFD_CLOEXEC;
+  if (huge_pages) flags |= MFD_HUGETLB;
+  int fd = int(syscall(SYS_memfd_create, "hsa_shared", flags));
+  if (fd == -1) return -1;
+  if (ftruncate(fd, off_t(size)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int OpenSharedMemory(uint32_t pid, int fd) {
+  std::string path =
+      "/proc/" + std::to_string(pid) + "/fd/" + std::to_string(fd);
+  return open(path.c_str(), O_RDWR | O_CLOEXEC);
+}
+
+int DuplicateSharedMemory(int fd) { return fcntl(fd, F_DUPFD_CLOEXEC, 0); }
+
+void* MapSharedMemory(int fd, size_t size) {
+  void* ret = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  return (ret == MAP_FAILED) ? NULL : ret;
+}
+
+void UnmapSharedMemory(void* ptr, size_t size) { munmap(ptr, size); }
+
+void CloseSharedMemory(int fd) { close(fd); }
+
+uint32_t GetProcessId() { return uint32_t(getpid()); }
+
+int CreatePollableEvent() { return eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK); }
+
+void SetPollableEvent(int fd) {
+  uint64_t one = 1;
+  ssize_t ret;
+  do {
+    ret = write(fd, &one, sizeof(one));
+  } while (ret == -1 && errno == EINTR);
+}
+
+int DuplicatePollableEvent(int fd) { return fcntl(fd, F_DUPFD_CLOEXEC, 0); }
+
+void DestroyPollableEvent(int fd) { close(fd); }
+
 struct ThreadArgs {
   void* entry_args;
   ThreadEntry entry_function;
@@ -122,6 +122,97 @@ void Sleep(int delayInMs);
 /// @return: void.
 void YieldThread();
 
+/// @brief: Blocks the current thread while the 32 bit word at address holds
+/// the expected value, until woken by WakeByAddress or the timeout expires.
+/// May return spuriously; callers must re-check their wait condition.
+/// @param: address(Input), address of the 32 bit word to wait on.
+/// @param: expected(Input), value the word must hold for the thread to block.
+/// @param: timeout_ns(Input), maximum time to block in nanoseconds.
+/// @param: shared(Input), true if the word is in memory shared with other
+/// processes and may be woken from them.
+/// @return: bool, false if the wait timed out.
+bool WaitOnAddress(volatile uint32_t* address, uint32_t expected,
+                   uint64_t timeout_ns, bool shared = false);
+
+/// @brief: Wakes threads blocked in WaitOnAddress on the given address.
+/// @param: address(Input), address of the 32 bit word being waited on.
+/// @param: count(Input), maximum number of threads to wake.
+/// @param: shared(Input), must match the waiters' shared argument.
+/// @return: void.
+void WakeByAddress(volatile uint32_t* address, uint32_t count,
+                   bool shared = false);
+
+/// @brief: Creates an anonymous shared memory object which other processes
+/// of the same user can open with OpenSharedMemory.
+/// @param: size(Input), size of the object in bytes.
+/// @param: huge_pages(Input), back the object with huge pages, size must then
+/// be a multiple of kHugePageSize. Mapping it fails if the system has too few
+/// huge pages available.
+/// @return: int, descriptor of the object, -1 if failed.
+int CreateSharedMemory(size_t size, bool huge_pages = false);
+
+/// @brief: Size of the huge pages used by CreateSharedMemory.
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+/// @brief: Opens a shared memory object created by another process. Requires
+/// the permission to trace the creating process, which the Yama ptrace_scope
+/// setting restricts to its ancestors by default.
+/// @param: pid(Input), id of the creating process.
+/// @param: fd(Input), descriptor of the object in the creating process.
+/// @return: int, descriptor of the object in this process, -1 if failed.
+int OpenSharedMemory(uint32_t pid, int fd);
+
+/// @brief: Duplicates a descriptor of a shared memory object held by this
+/// process, for example one received over a Unix socket.
+/// @param: fd(Input), the descriptor.
+/// @return: int, the duplicate, -1 if failed.
+int DuplicateSharedMemory(int fd);
+
+/// @brief: Maps a shared memory object read/write.
+/// @param: fd(Input), descriptor of the object.
+/// @param: size(Input), size of the mapping in bytes.
+/// @return: void*, address of the mapping, NULL if failed.
+void* MapSharedMemory(int fd, size_t size);
+
+/// @brief: Unmaps a mapping made by MapSharedMemory.
+/// @param: ptr(Input), address of the mapping.
+/// @param: size(Input), size of the mapping in bytes.
+/// @return: void.
+void UnmapSharedMemory(void* ptr, size_t size);
+
+/// @brief: Closes a descriptor of a shared memory object.
+/// @param: fd(Input), the descriptor.
+/// @return: void.
+void CloseSharedMemory(int fd);
+
+/// @brief: Gets the id of the calling process.
+/// @param: void.
+/// @return: uint32_t, the process id.
+uint32_t GetProcessId();
+
+/// @brief: Creates a non-blocking file descriptor which can be polled and
+/// becomes readable once set. Reading it returns and clears the number of
+/// times it was set.
+/// @param: void.
+/// @return: int, the descriptor, -1 if failed.
+int CreatePollableEvent();
+
+/// @brief: Makes a descriptor from CreatePollableEvent readable.
+/// @param: fd(Input), the descriptor.
+/// @return: void.
+void SetPollableEvent(int fd);
+
+/// @brief: Duplicates a pollable descriptor, such as one from
+/// CreatePollableEvent or an eventfd supplied by the application.
+/// @param: fd(Input), the descriptor.
+/// @return: int, the duplicate, -1 if failed.
+int DuplicatePollableEvent(int fd);
+
+/// @brief: Closes a descriptor from CreatePollableEvent.
+/// @param: fd(Input), the descriptor.
+/// @return: void.
+void DestroyPollableEvent(int fd);
+
 typedef void (*ThreadEntry)(void*);
 
 /// @brief: Creates a thread will return NULL if failed.
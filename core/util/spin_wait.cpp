@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "core/util/spin_wait.h"
+
+#include <cpuid.h>
+
+SpinWait::Mode SpinWait::mode_ = SpinWait::kPause;
+uint64_t SpinWait::slice_ticks_ = 4000;
+uint32_t SpinWait::max_pauses_ = 64;
+
+// One slice, short enough to keep deadlines and phase changes responsive.
+static const uint64_t kSliceNs = 1000;
+
+void SpinWait::Init(uint64_t tsc_frequency, bool allow_monitor) {
+  // Without a measured rate assume 4GHz.
+  if (tsc_frequency != 0)
+    slice_ticks_ = Max(tsc_frequency / (1000000000 / kSliceNs), uint64_t(1));
+
+  // PAUSE latency varies from about 10 to about 140 cycles between cores.
+  const uint32_t kSamplePauses = 256;
+  uint64_t start = __rdtsc();
+  for (uint32_t i = 0; i < kSamplePauses; i++) _mm_pause();
+  uint64_t ticks = Max(uint64_t(__rdtsc() - start), uint64_t(1));
+  uint64_t pauses = slice_ticks_ * kSamplePauses / ticks;
+  pauses = Min(pauses, uint64_t(UINT32_MAX / 2));
+  max_pauses_ = uint32_t(Max(pauses, uint64_t(1)));
+
+  mode_ = kPause;
+  if (!allow_monitor) return;
+
+  // __get_cpuid_count is newer than the supported compilers, check the
+  // highest leaf before using __cpuid_count.
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_max(0, NULL) >= 7) {
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if ((ecx & (1u << 5)) != 0) {
+      mode_ = kUmwait;
+      return;
+    }
+  }
+  if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) &&
+      (ecx & (1u << 29)) != 0)
+    mode_ = kMwaitx;
+}
+
+// The monitor instructions are emitted as bytes since the intrinsics and
+// target attributes need newer compilers than the supported ones.
+
+void SpinWait::UmWait(volatile int64_t* address, int64_t expected) {
+  // umonitor %rax
+  __asm__ __volatile__(".byte 0xf3, 0x0f, 0xae, 0xf0"
+                       :
+                       : "a"(address)
+                       : "memory");
+  // Re-check after arming, a write in between would otherwise be missed.
+  if (*address != expected) return;
+  // umwait %ecx, C0.1 is the state with the lowest wake latency.
+  uint64_t deadline = __rdtsc() + slice_ticks_;
+  const uint32_t kC01 = 1;
+  __asm__ __volatile__(".byte 0xf2, 0x0f, 0xae, 0xf1"
+                       :
+                       : "c"(kC01), "a"(uint32_t(deadline)),
+                         "d"(uint32_t(deadline >> 32))
+                       : "cc", "memory");
+}
+
+void SpinWait::MwaitX(volatile int64_t* address, int64_t expected) {
+  // monitorx %rax, %ecx, %edx
+  __asm__ __volatile__(".byte 0x0f, 0x01, 0xfa"
+                       :
+                       : "a"(address), "c"(0), "d"(0)
+                       : "memory");
+  if (*address != expected) return;
+  // mwaitx %eax, %ecx, with the timer in %ebx enabled. It counts at the TSC
+  // rate. %ebx is swapped in since it may hold the PIC register on 32 bit
+  // targets.
+  const uint32_t kMwaitxTimer = 2;
+  uint32_t timeout = uint32_t(Min(slice_ticks_, uint64_t(UINT32_MAX)));
+  __asm__ __volatile__(
+      "xchg %%ebx, %0\n\t"
+      ".byte 0x0f, 0x01, 0xfb\n\t"
+      "xchg %%ebx, %0"
+      : "+r"(timeout)
+      : "a"(0), "c"(kMwaitxTimer)
+      : "memory");
+}
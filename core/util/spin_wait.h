@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Low power waiting for short spin phases.
+
+#ifndef HSA_RUNTIME_CORE_UTIL_SPIN_WAIT_H_
+#define HSA_RUNTIME_CORE_UTIL_SPIN_WAIT_H_
+
+#include "utils.h"
+
+/// @brief: Paces a thread spinning on a memory location. Where the CPU
+/// supports it the thread waits in a light power state until the location is
+/// written, with UMONITOR/UMWAIT (WAITPKG) or MONITORX/MWAITX. Otherwise it
+/// executes a backoff of PAUSE instructions calibrated so that one step lasts
+/// at most about a slice. Each call returns within about a slice so callers
+/// can re-check their wait condition and deadlines.
+class SpinWait {
+ public:
+  SpinWait() : pauses_(1) {}
+
+  /// @brief: Selects the wait primitive from cpuid and calibrates PAUSE.
+  /// @param: tsc_frequency(Input), TSC rate in Hz, 0 if unknown.
+  /// @param: allow_monitor(Input), false to only use PAUSE.
+  static void Init(uint64_t tsc_frequency, bool allow_monitor);
+
+  /// @brief: Waits until the 64 bit word at address may no longer hold
+  /// expected, or about a slice has passed. May return early.
+  /// @param: address(Input), address of the word, 8 byte aligned.
+  /// @param: expected(Input), last value observed at address.
+  __forceinline void Wait(volatile int64_t* address, int64_t expected) {
+    switch (mode_) {
+      case kUmwait:
+        UmWait(address, expected);
+        return;
+      case kMwaitx:
+        MwaitX(address, expected);
+        return;
+      default:
+        Pause();
+        return;
+    }
+  }
+
+  /// @brief: Executes the next step of the PAUSE backoff, for waits on more
+  /// than one location.
+  __forceinline void Pause() {
+    for (uint32_t i = 0; i < pauses_; i++) _mm_pause();
+    if (pauses_ < max_pauses_) pauses_ *= 2;
+  }
+
+ private:
+  enum Mode { kPause, kUmwait, kMwaitx };
+
+  static void UmWait(volatile int64_t* address, int64_t expected);
+
+  static void MwaitX(volatile int64_t* address, int64_t expected);
+
+  static Mode mode_;
+
+  /// @brief: Length of a slice in TSC ticks.
+  static uint64_t slice_ticks_;
+
+  /// @brief: Number of PAUSE instructions which take about a slice.
+  static uint32_t max_pauses_;
+
+  // Pauses executed by the next backoff step.
+  uint32_t pauses_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpinWait);
+};
+
+#endif  // HSA_RUNTIME_CORE_UTIL_SPIN_WAIT_H_
@@ -52,6 +52,10 @@
 #include "hsa.h"
 #include "hsa_ext_finalize.h"
 
+#ifndef __cplusplus
+#include "stdbool.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -94,6 +98,210 @@ hsa_status_t HSA_API hsa_ext_get_dispatch_times(hsa_agent_t agent,
                                                 hsa_signal_t signal,
                                                 hsa_amd_dispatch_time_t* time);
 
+//===----------------------------------------------------------------------===//
+// AMD Queue APIs.                                                            //
+//===----------------------------------------------------------------------===//
+
+// Submits count 64 byte AQL packets, headers included, to consecutive slots
+// of the queue. Reserves the slots with one write index update, waiting while
+// the queue is full, publishes the headers in order with release semantics
+// and rings the doorbell once. count must not exceed the queue size.
+hsa_status_t HSA_API
+    hsa_amd_queue_submit(hsa_queue_t* queue, const void* packets,
+                         uint32_t count);
+
+//===----------------------------------------------------------------------===//
+// AMD Agent Dispatch APIs.                                                   //
+//===----------------------------------------------------------------------===//
+
+// Host function executing agent dispatch packets submitted to queues of CPU
+// agents. Called from the queue's executor thread, one packet at a time in
+// queue order. The packet's completion signal is decremented once it returns.
+typedef void (*hsa_amd_agent_dispatch_handler)(
+    const hsa_agent_dispatch_packet_t* packet, void* data);
+
+// Registers the handler of agent dispatch packets with the given type,
+// replacing any previous one. A NULL handler removes the registration.
+// Packets without a handler are reported to the queue's error callback with
+// HSA_STATUS_ERROR_INVALID_PACKET_FORMAT and then completed.
+hsa_status_t HSA_API
+    hsa_amd_agent_dispatch_register(uint16_t type,
+                                    hsa_amd_agent_dispatch_handler handler,
+                                    void* data);
+
+//===----------------------------------------------------------------------===//
+// AMD Signal APIs.                                                           //
+//===----------------------------------------------------------------------===//
+
+// Wait conditions which treat the signal value as a set of flags and the
+// compare value as a mask. Accepted, cast to hsa_signal_condition_t, by every
+// signal wait API and by hsa_amd_signal_async_handler.
+typedef enum hsa_amd_signal_condition_s {
+  // Satisfied when (value & mask) == mask.
+  HSA_AMD_ALL_BITS_SET = 4,
+  // Satisfied when (value & mask) != 0.
+  HSA_AMD_ANY_BIT_SET = 5
+} hsa_amd_signal_condition_t;
+
+// Creates count signals with a single allocation from the signal pool. The
+// signals may be destroyed individually with hsa_signal_destroy or together
+// with hsa_amd_signal_destroy_batch. As with hsa_signal_create, signals whose
+// consumers are all GPU agents are plain memory signals without a KFD event.
+hsa_status_t HSA_API
+    hsa_amd_signal_create_batch(uint32_t count,
+                                hsa_signal_value_t initial_value,
+                                uint32_t num_consumers,
+                                const hsa_agent_t* consumers,
+                                hsa_signal_t* signals);
+
+// Destroys count signals created by hsa_signal_create or
+// hsa_amd_signal_create_batch. Nothing is destroyed if any signal is invalid,
+// or if a signal is listed more than once, which returns
+// HSA_STATUS_ERROR_INVALID_ARGUMENT.
+hsa_status_t HSA_API
+    hsa_amd_signal_destroy_batch(uint32_t count, const hsa_signal_t* signals);
+
+// Waits until any signal satisfies its condition. Returns the index of the
+// satisfying signal, or UINT32_MAX on timeout.
+uint32_t HSA_API
+    hsa_amd_signal_wait_any(uint32_t signal_count, hsa_signal_t* signals,
+                            hsa_signal_condition_t* conds,
+                            hsa_signal_value_t* values, uint64_t timeout_hint,
+                            hsa_wait_expectancy_t wait_hint,
+                            hsa_signal_value_t* satisfying_value);
+
+// Waits until every signal has been observed satisfying its condition. Returns
+// the number of satisfied signals, less than signal_count on timeout.
+uint32_t HSA_API
+    hsa_amd_signal_wait_all(uint32_t signal_count, hsa_signal_t* signals,
+                            hsa_signal_condition_t* conds,
+                            hsa_signal_value_t* values, uint64_t timeout_hint,
+                            hsa_wait_expectancy_t wait_hint,
+                            hsa_signal_value_t* satisfying_values);
+
+// Handler invoked from the runtime's async events thread with the value which
+// satisfied the condition. Returning true keeps the handler registered.
+typedef bool (*hsa_amd_signal_handler)(hsa_signal_value_t value, void* arg);
+
+// Registers a handler to be called once the signal satisfies the condition.
+// If the signal is destroyed first the handler is dropped without being
+// called. The async events thread sleeps in the kernel while every watched
+// signal is an interrupt or hybrid signal, otherwise it polls about once per
+// millisecond.
+hsa_status_t HSA_API
+    hsa_amd_signal_async_handler(hsa_signal_t signal,
+                                 hsa_signal_condition_t cond,
+                                 hsa_signal_value_t value,
+                                 hsa_amd_signal_handler handler, void* arg);
+
+// Called from the runtime's async events thread in place of the handler when
+// the handler is dropped before returning false, because the signal was
+// destroyed or the runtime shut down.
+typedef void (*hsa_amd_signal_cancel_handler)(void* arg);
+
+// As hsa_amd_signal_async_handler, calling cancel with arg if the handler is
+// dropped before it returned false.
+hsa_status_t HSA_API
+    hsa_amd_signal_async_handler_cancelable(
+        hsa_signal_t signal, hsa_signal_condition_t cond,
+        hsa_signal_value_t value, hsa_amd_signal_handler handler,
+        hsa_amd_signal_cancel_handler cancel, void* arg);
+
+// Adds 1 to the counter of an eventfd once the signal satisfies the condition,
+// making it readable. The same descriptor may be attached to several signals,
+// reading it returns the number of conditions met since the last read. The
+// runtime notifies through its own duplicate of the descriptor, released once
+// the condition is met or the signal is destroyed, so the caller may close fd
+// at any time.
+hsa_status_t HSA_API
+    hsa_amd_signal_attach_eventfd(hsa_signal_t signal,
+                                  hsa_signal_condition_t cond,
+                                  hsa_signal_value_t value, int fd);
+
+// Creates a non-blocking eventfd attached to the signal as by
+// hsa_amd_signal_attach_eventfd. The caller owns and closes the returned
+// descriptor, the runtime keeps its own duplicate until done with it.
+hsa_status_t HSA_API
+    hsa_amd_signal_get_eventfd(hsa_signal_t signal,
+                               hsa_signal_condition_t cond,
+                               hsa_signal_value_t value, int* fd);
+
+// Handle which lets another process of the same user attach to a signal
+// created by hsa_amd_signal_ipc_create. It stays valid while the process
+// named by pid keeps the signal.
+//
+// The descriptor may be passed to the attaching process over a Unix socket
+// with SCM_RIGHTS, the receiver then sets pid to its own process id and fd to
+// the received descriptor. Otherwise the descriptor is opened through
+// /proc/<pid>/fd, which requires permission to trace the process named by
+// pid; with the default Yama ptrace_scope of 1 only its ancestors have it.
+typedef struct hsa_amd_ipc_signal_s {
+  // Id of the process holding fd.
+  uint32_t pid;
+  // Descriptor of the signal's shared memory in that process.
+  int32_t fd;
+  // Identifies the signal, so that a stale handle whose descriptor number
+  // was reused fails to attach.
+  uint64_t id;
+} hsa_amd_ipc_signal_t;
+
+// Creates a signal whose value lives in memory which other processes can
+// attach to with hsa_amd_signal_ipc_attach. Waits in any process are woken by
+// updates made in any process. The signal cannot be used in AQL packets,
+// device completions are forwarded to it from the host, for example with
+// hsa_amd_signal_async_handler.
+hsa_status_t HSA_API
+    hsa_amd_signal_ipc_create(hsa_signal_value_t initial_value,
+                              hsa_signal_t* signal);
+
+// Gets the handle of a signal created by hsa_amd_signal_ipc_create or attached
+// with hsa_amd_signal_ipc_attach.
+hsa_status_t HSA_API
+    hsa_amd_signal_ipc_handle_get(hsa_signal_t signal,
+                                  hsa_amd_ipc_signal_t* handle);
+
+// Attaches to a signal exported by another process. The signal supports the
+// host signal operations and waits but cannot be used in AQL packets. It is
+// released with hsa_signal_destroy, and reads as retired (waits return 0) once
+// the creating process destroys it. Fails with
+// HSA_STATUS_ERROR_INVALID_ARGUMENT if the descriptor cannot be opened or no
+// longer refers to the signal.
+hsa_status_t HSA_API
+    hsa_amd_signal_ipc_attach(const hsa_amd_ipc_signal_t* handle,
+                              hsa_signal_t* signal);
+
+// Wait statistics of one signal. Recorded only when the HSA_SIGNAL_STATS
+// environment variable is set to 1.
+typedef struct hsa_amd_signal_stats_s {
+  // Completed waits.
+  uint64_t wait_count;
+  // Waits which returned because the timeout expired.
+  uint64_t timeout_count;
+  // Total time spent waiting.
+  uint64_t wait_time_ns;
+  // Part of wait_time_ns spent blocked in the kernel.
+  uint64_t blocked_time_ns;
+  // Condition checks which failed while spinning.
+  uint64_t spin_count;
+  // Number of times a waiter blocked.
+  uint64_t block_count;
+  // Blocks ended by a notification from a signal update.
+  uint64_t notified_wake_count;
+  // Blocks ended because their time slice expired.
+  uint64_t timed_wake_count;
+} hsa_amd_signal_stats_t;
+
+hsa_status_t HSA_API hsa_amd_signal_get_stats(hsa_signal_t signal,
+                                              hsa_amd_signal_stats_t* stats);
+
+#define HSA_AMD_SIGNAL_WAIT_HISTOGRAM_BUCKETS 40
+
+// Copies the process wide histogram of wait durations. Bucket i counts waits
+// which took [2^i, 2^(i+1)) nanoseconds, the last bucket also counts all
+// longer waits.
+hsa_status_t HSA_API
+    hsa_amd_signal_get_wait_histogram(uint64_t* buckets,
+                                      uint32_t bucket_count);
 
 //===----------------------------------------------------------------------===//
 // Extra Finalizer Core APIs.                                                 //
@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2014 ADVANCED MICRO DEVICES, INC.
+//
+// AMD is granting you permission to use this software and documentation(if any)
+// (collectively, the Materials) pursuant to the terms and conditions of the
+// Software License Agreement included with the Materials.If you do not have a
+// copy of the Software License Agreement, contact your AMD representative for a
+// copy.
+//
+// You agree that you will not reverse engineer or decompile the Materials, in
+// whole or in part, except as allowed by applicable law.
+//
+// WARRANTY DISCLAIMER : THE SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND.AMD DISCLAIMS ALL WARRANTIES, EXPRESS, IMPLIED, OR STATUTORY,
+// INCLUDING BUT NOT LIMITED TO THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE, NON - INFRINGEMENT, THAT THE
+// SOFTWARE WILL RUN UNINTERRUPTED OR ERROR - FREE OR WARRANTIES ARISING FROM
+// CUSTOM OF TRADE OR COURSE OF USAGE.THE ENTIRE RISK ASSOCIATED WITH THE USE OF
+// THE SOFTWARE IS ASSUMED BY YOU.Some jurisdictions do not allow the exclusion
+// of implied warranties, so the above exclusion may not apply to You.
+//
+// LIMITATION OF LIABILITY AND INDEMNIFICATION : AMD AND ITS LICENSORS WILL NOT,
+// UNDER ANY CIRCUMSTANCES BE LIABLE TO YOU FOR ANY PUNITIVE, DIRECT,
+// INCIDENTAL, INDIRECT, SPECIAL OR CONSEQUENTIAL DAMAGES ARISING FROM USE OF
+// THE SOFTWARE OR THIS AGREEMENT EVEN IF AMD AND ITS LICENSORS HAVE BEEN
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.In no event shall AMD's total
+// liability to You for all damages, losses, and causes of action (whether in
+// contract, tort (including negligence) or otherwise) exceed the amount of $100
+// USD.  You agree to defend, indemnify and hold harmless AMD and its licensors,
+// and any of their directors, officers, employees, affiliates or agents from
+// and against any and all loss, damage, liability and other expenses (including
+// reasonable attorneys' fees), resulting from Your use of the Software or
+// violation of the terms and conditions of this Agreement.
+//
+// U.S.GOVERNMENT RESTRICTED RIGHTS : The Materials are provided with
+// "RESTRICTED RIGHTS." Use, duplication, or disclosure by the Government is
+// subject to the restrictions as set forth in FAR 52.227 - 14 and DFAR252.227 -
+// 7013, et seq., or its successor.Use of the Materials by the Government
+// constitutes acknowledgement of AMD's proprietary rights in them.
+//
+// EXPORT RESTRICTIONS: The Materials may be subject to export restrictions as
+//                      stated in the Software License Agreement.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// C++20 coroutine support for HSA signals.
+//
+// co_await hsa::until(signal, HSA_EQ, 0, executor, context) suspends the
+// calling coroutine without blocking a thread. The runtime's async events
+// thread watches the signal and hands the coroutine to the executor once the
+// condition holds. The await yields the satisfying value with acquire
+// semantics, like hsa_signal_wait_acquire, or an error if the signal is
+// destroyed first.
+
+#ifndef HSA_RUNTIME_EXT_AMD_COROUTINE_H_
+#define HSA_RUNTIME_EXT_AMD_COROUTINE_H_
+
+#include "hsa.h"
+#include "hsa_ext_amd.h"
+
+// __has_include must not appear in an #if unless the compiler provides it.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define HSA_EXT_AMD_COROUTINE_SUPPORTED 1
+#endif
+#endif
+
+#ifdef HSA_EXT_AMD_COROUTINE_SUPPORTED
+
+#include <atomic>
+#include <coroutine>
+
+namespace hsa {
+
+// Resumes a coroutine, for example by posting it to a thread pool. Called on
+// the runtime's async events thread, which is shared by every async handler in
+// the process, so it must hand the coroutine off rather than resume it inline.
+typedef void (*resume_executor_t)(void* context,
+                                  std::coroutine_handle<> coroutine);
+
+// Result of awaiting a signal. status is HSA_STATUS_SUCCESS with the
+// satisfying value, HSA_STATUS_ERROR_INVALID_SIGNAL if the signal was
+// destroyed, or the runtime shut down, before the condition held, or
+// HSA_STATUS_ERROR_INVALID_ARGUMENT if the condition is not a valid wait
+// condition.
+struct signal_result {
+  hsa_status_t status;
+  hsa_signal_value_t value;
+};
+
+// Awaitable returned by until().
+class signal_awaiter {
+ public:
+  signal_awaiter(hsa_signal_t signal, hsa_signal_condition_t cond,
+                 hsa_signal_value_t value, resume_executor_t executor,
+                 void* context) noexcept
+      : signal_(signal),
+        cond_(cond),
+        compare_value_(value),
+        status_(HSA_STATUS_SUCCESS),
+        value_(0),
+        executor_(executor),
+        context_(context) {}
+
+  bool await_ready() noexcept {
+    if (!valid_condition()) {
+      status_ = HSA_STATUS_ERROR_INVALID_ARGUMENT;
+      return true;
+    }
+    value_ = hsa_signal_load_acquire(signal_);
+    return satisfied(value_);
+  }
+
+  bool await_suspend(std::coroutine_handle<> coroutine) noexcept {
+    coroutine_ = coroutine;
+    if (executor_ != nullptr) {
+      // The handler may run, and resume the coroutine, before registration
+      // returns, so this must not be touched once registered.
+      hsa_status_t err = hsa_amd_signal_async_handler_cancelable(
+          signal_, cond_, compare_value_, &resume, &cancel, this);
+      if (err == HSA_STATUS_SUCCESS) return true;
+      if (err != HSA_STATUS_ERROR_OUT_OF_RESOURCES) {
+        status_ = err;
+        return false;
+      }
+    }
+
+    // Without an executor, or if the async events thread could not be
+    // started, wait on this thread.
+    value_ = hsa_signal_wait_acquire(signal_, cond_, compare_value_,
+                                     UINT64_MAX, HSA_WAIT_EXPECTANCY_UNKNOWN);
+    return false;
+  }
+
+  signal_result await_resume() noexcept {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    signal_result result = {status_, value_};
+    return result;
+  }
+
+ private:
+  // Accepts the conditions the runtime's signal waits accept.
+  bool valid_condition() const noexcept {
+    switch (uint32_t(cond_)) {
+      case HSA_EQ:
+      case HSA_NE:
+      case HSA_LT:
+      case HSA_GTE:
+      case HSA_AMD_ALL_BITS_SET:
+      case HSA_AMD_ANY_BIT_SET:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  bool satisfied(hsa_signal_value_t value) const noexcept {
+    switch (uint32_t(cond_)) {
+      case HSA_EQ:
+        return value == compare_value_;
+      case HSA_NE:
+        return value != compare_value_;
+      case HSA_LT:
+        return value < compare_value_;
+      case HSA_GTE:
+        return value >= compare_value_;
+      case HSA_AMD_ALL_BITS_SET:
+        return (value & compare_value_) == compare_value_;
+      case HSA_AMD_ANY_BIT_SET:
+        return (value & compare_value_) != 0;
+      default:
+        return false;
+    }
+  }
+
+  static bool resume(hsa_signal_value_t value, void* arg) {
+    signal_awaiter* self = static_cast<signal_awaiter*>(arg);
+    self->value_ = value;
+    self->executor_(self->context_, self->coroutine_);
+    return false;
+  }
+
+  // Resumes with an error rather than leaving the coroutine suspended when
+  // the signal is destroyed.
+  static void cancel(void* arg) {
+    signal_awaiter* self = static_cast<signal_awaiter*>(arg);
+    self->status_ = HSA_STATUS_ERROR_INVALID_SIGNAL;
+    self->executor_(self->context_, self->coroutine_);
+  }
+
+  hsa_signal_t signal_;
+  hsa_signal_condition_t cond_;
+  hsa_signal_value_t compare_value_;
+  hsa_status_t status_;
+  hsa_signal_value_t value_;
+  resume_executor_t executor_;
+  void* context_;
+  std::coroutine_handle<> coroutine_;
+};
+
+// Suspends until the signal satisfies the condition, then resumes the
+// coroutine through executor. A NULL executor waits on the calling thread
+// instead of suspending.
+inline signal_awaiter until(hsa_signal_t signal, hsa_signal_condition_t cond,
+                            hsa_signal_value_t value,
+                            resume_executor_t executor,
+                            void* context) noexcept {
+  return signal_awaiter(signal, cond, value, executor, context);
+}
+
+}  // namespace hsa
+
+#endif  // HSA_EXT_AMD_COROUTINE_SUPPORTED
+
+#endif  // header guard